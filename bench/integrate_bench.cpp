@@ -0,0 +1,53 @@
+// Microbenchmark for SPLIntegrator, reports ns/particle for every kernel the CPU supports.
+// That the kernels agree with the scalar one is checked by integrate_test.
+
+#include "integrate_scene.h"
+
+#include <fmt/format.h>
+
+#include <chrono>
+#include <vector>
+
+namespace {
+
+constexpr u32 BLOCK_COUNT = 1024; // 64k particles
+constexpr u32 ITERATIONS = 500;
+constexpr f32 DELTA_TIME = 1.0f / 60.0f;
+
+f64 run(SPLSimdLevel level) {
+    SPLIntegrator::setLevel(level);
+
+    const std::vector<u32> counts(BLOCK_COUNT, SPLParticleBlock::CAPACITY);
+    auto scene = makeIntegrateScene(1, counts);
+
+    const auto start = std::chrono::steady_clock::now();
+    for (u32 it = 0; it < ITERATIONS; ++it) {
+        stepIntegrateScene(scene, DELTA_TIME);
+    }
+    const auto end = std::chrono::steady_clock::now();
+
+    const f64 ns = (f64)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    return ns / ((f64)ITERATIONS * BLOCK_COUNT * SPLParticleBlock::CAPACITY);
+}
+
+}
+
+int main() {
+    const auto supported = SPLIntegrator::getSupportedLevel();
+    fmt::print("{} particles, {} iterations, best supported kernel: {}\n",
+        BLOCK_COUNT * SPLParticleBlock::CAPACITY, ITERATIONS, SPLIntegrator::getLevelName(supported));
+
+    const f64 scalarTime = run(SPLSimdLevel::Scalar);
+    fmt::print("{:>8}: {:.3f} ns/particle\n", SPLIntegrator::getLevelName(SPLSimdLevel::Scalar), scalarTime);
+
+    for (const auto level : { SPLSimdLevel::SSE41, SPLSimdLevel::AVX2 }) {
+        if (level > supported) {
+            continue;
+        }
+
+        const f64 time = run(level);
+        fmt::print("{:>8}: {:.3f} ns/particle ({:.2f}x)\n", SPLIntegrator::getLevelName(level), time, scalarTime / time);
+    }
+
+    return 0;
+}
@@ -0,0 +1,241 @@
+// Headless simulation benchmark. Loads .spa files, spawns looping emitters for every resource
+// into a ParticleSystem without a GL context and runs a fixed number of fixed-step frames.
+// Results are printed as JSON so runs of different builds can be compared by scripts.
+
+#include "spl/particle_system.h"
+#include "spl/spl_archive.h"
+#include "spl/spl_integrate.h"
+#include "util/allocation_counter.h"
+#include "util/thread_pool.h"
+
+#include <argparse/argparse.hpp>
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+namespace {
+
+// Names a kernel specialization by its features, e.g. "scale+alpha+children"
+std::string getKernelName(u32 features, std::span<const std::pair<u32, const char*>> names) {
+    std::string name;
+    for (const auto& [feature, featureName] : names) {
+        if (features & feature) {
+            name += name.empty() ? featureName : std::string("+") + featureName;
+        }
+    }
+
+    return name.empty() ? "plain" : name;
+}
+
+constexpr std::pair<u32, const char*> KERNEL_FEATURE_NAMES[] = {
+    { SPLEmitter::KernelScaleAnim, "scale" },
+    { SPLEmitter::KernelColorAnim, "color" },
+    { SPLEmitter::KernelAlphaAnim, "alpha" },
+    { SPLEmitter::KernelTexAnim, "tex" },
+    { SPLEmitter::KernelFollowEmitter, "follow" },
+    { SPLEmitter::KernelChildren, "children" },
+};
+
+constexpr std::pair<u32, const char*> CHILD_KERNEL_FEATURE_NAMES[] = {
+    { SPLEmitter::ChildKernelScaleAnim, "scale" },
+    { SPLEmitter::ChildKernelAlphaAnim, "alpha" },
+    { SPLEmitter::ChildKernelFollowEmitter, "follow" },
+};
+
+struct Options {
+    u32 frames;
+    u32 warmupFrames;
+    f32 prewarmSeconds;
+    u32 emittersPerResource;
+    u32 maxParticles;
+    u32 threads;
+    BudgetPolicy budgetPolicy;
+};
+
+nlohmann::json runFile(const std::filesystem::path& path, const Options& options) {
+    const SPLArchive archive(path);
+    const auto& resources = archive.getResources();
+
+    ThreadPool* threadPool = nullptr;
+    std::unique_ptr<ThreadPool> ownedPool;
+    if (options.threads > 1) {
+        ownedPool = std::make_unique<ThreadPool>(options.threads - 1);
+        threadPool = ownedPool.get();
+    }
+
+    ParticleSystem system(options.maxParticles);
+    system.setFixedTimestep(true);
+    system.setThreadPool(threadPool);
+    system.setBudgetPolicy(options.budgetPolicy);
+
+    for (const auto& resource : resources) {
+        for (u32 i = 0; i < options.emittersPerResource; ++i) {
+            system.addEmitter(resource, true);
+        }
+    }
+
+    if (options.prewarmSeconds > 0.0f) {
+        system.prewarm(options.prewarmSeconds);
+    }
+
+    for (u32 frame = 0; frame < options.warmupFrames; ++frame) {
+        system.update(ParticleSystem::FIXED_TIMESTEP);
+    }
+
+    u64 particleUpdates = 0;
+    u32 peakParticles = 0;
+
+    const u64 deniedBefore = system.getDeniedSpawns();
+
+    std::array<u64, SPLEmitter::PARTICLE_KERNEL_COUNT> kernelsBefore;
+    for (u32 i = 0; i < SPLEmitter::PARTICLE_KERNEL_COUNT; ++i) {
+        kernelsBefore[i] = SPLEmitter::getParticleKernelUsage(i);
+    }
+
+    std::array<u64, SPLEmitter::CHILD_KERNEL_COUNT> childKernelsBefore;
+    for (u32 i = 0; i < SPLEmitter::CHILD_KERNEL_COUNT; ++i) {
+        childKernelsBefore[i] = SPLEmitter::getChildKernelUsage(i);
+    }
+
+    const u64 allocationsBefore = AllocationCounter::getCount();
+    const auto start = std::chrono::steady_clock::now();
+
+    for (u32 frame = 0; frame < options.frames; ++frame) {
+        system.update(ParticleSystem::FIXED_TIMESTEP);
+
+        const u32 count = system.getParticleCount();
+        particleUpdates += count;
+        peakParticles = std::max(peakParticles, count);
+    }
+
+    const auto end = std::chrono::steady_clock::now();
+    const u64 allocations = AllocationCounter::getCount() - allocationsBefore;
+
+    const f64 seconds = std::chrono::duration<f64>(end - start).count();
+    const f64 nanoseconds = seconds * 1e9;
+
+    // Emitter updates per kernel specialization during the measured frames
+    auto kernels = nlohmann::json::object();
+    for (u32 i = 0; i < SPLEmitter::PARTICLE_KERNEL_COUNT; ++i) {
+        if (const u64 updates = SPLEmitter::getParticleKernelUsage(i) - kernelsBefore[i]) {
+            kernels[getKernelName(i, KERNEL_FEATURE_NAMES)] = updates;
+        }
+    }
+
+    auto childKernels = nlohmann::json::object();
+    for (u32 i = 0; i < SPLEmitter::CHILD_KERNEL_COUNT; ++i) {
+        if (const u64 updates = SPLEmitter::getChildKernelUsage(i) - childKernelsBefore[i]) {
+            childKernels[getKernelName(i, CHILD_KERNEL_FEATURE_NAMES)] = updates;
+        }
+    }
+
+    return {
+        { "path", path.string() },
+        { "resources", resources.size() },
+        { "emitters", resources.size() * options.emittersPerResource },
+        { "seconds", seconds },
+        { "framesPerSecond", seconds > 0.0 ? options.frames / seconds : 0.0 },
+        { "nsPerFrame", options.frames > 0 ? nanoseconds / options.frames : 0.0 },
+        { "particleUpdates", particleUpdates },
+        { "nsPerParticleUpdate", particleUpdates > 0 ? nanoseconds / (f64)particleUpdates : 0.0 },
+        { "peakParticles", peakParticles },
+        { "deniedSpawns", system.getDeniedSpawns() - deniedBefore },
+        { "kernels", kernels },
+        { "childKernels", childKernels },
+        { "allocations", allocations },
+        { "allocationsPerFrame", options.frames > 0 ? (f64)allocations / options.frames : 0.0 },
+    };
+}
+
+}
+
+int main(int argc, char** argv) {
+    argparse::ArgumentParser program("nitroefx_bench");
+    program.add_argument("files").help("Paths to .spa files").nargs(argparse::nargs_pattern::at_least_one);
+    program.add_argument("-n", "--frames").help("Number of measured frames").default_value(900u).scan<'u', u32>();
+    program.add_argument("-w", "--warmup").help("Number of frames simulated before measuring").default_value(90u).scan<'u', u32>();
+    program.add_argument("--prewarm").help("Seconds to fast-forward before the warmup frames").default_value(0.0f).scan<'g', f32>();
+    program.add_argument("-e", "--emitters").help("Looping emitters spawned per resource").default_value(1u).scan<'u', u32>();
+    program.add_argument("-p", "--max-particles").help("Particle budget").default_value(1000u).scan<'u', u32>();
+    program.add_argument("-t", "--threads").help("Update threads, 1 = main thread only").default_value(1u).scan<'u', u32>();
+    program.add_argument("-b", "--budget-policy").help("How a short particle budget is shared: first-come, fair or priority").default_value(std::string("first-come"));
+    program.add_argument("-o", "--output").help("Write the JSON report to a file instead of stdout");
+
+    try {
+        program.parse_args(argc, argv);
+    } catch (const std::exception& err) {
+        spdlog::error("Error parsing arguments: {}", err.what());
+        return 1;
+    }
+
+    BudgetPolicy budgetPolicy;
+    const auto policyName = program.get<std::string>("--budget-policy");
+    if (policyName == "first-come") {
+        budgetPolicy = BudgetPolicy::FirstCome;
+    } else if (policyName == "fair") {
+        budgetPolicy = BudgetPolicy::Fair;
+    } else if (policyName == "priority") {
+        budgetPolicy = BudgetPolicy::Priority;
+    } else {
+        spdlog::error("Unknown budget policy: {}", policyName);
+        return 1;
+    }
+
+    const Options options = {
+        .frames = program.get<u32>("--frames"),
+        .warmupFrames = program.get<u32>("--warmup"),
+        .prewarmSeconds = program.get<f32>("--prewarm"),
+        .emittersPerResource = program.get<u32>("--emitters"),
+        .maxParticles = program.get<u32>("--max-particles"),
+        .threads = std::max(program.get<u32>("--threads"), 1u),
+        .budgetPolicy = budgetPolicy,
+    };
+
+    nlohmann::json report = {
+        { "frames", options.frames },
+        { "warmupFrames", options.warmupFrames },
+        { "prewarmSeconds", options.prewarmSeconds },
+        { "timestep", ParticleSystem::FIXED_TIMESTEP },
+        { "emittersPerResource", options.emittersPerResource },
+        { "maxParticles", options.maxParticles },
+        { "threads", options.threads },
+        { "budgetPolicy", policyName },
+        { "simd", SPLIntegrator::getLevelName(SPLIntegrator::getLevel()) },
+        { "files", nlohmann::json::array() },
+    };
+
+    for (const auto& file : program.get<std::vector<std::string>>("files")) {
+        if (!std::filesystem::exists(file)) {
+            spdlog::error("File not found: {}", file);
+            return 1;
+        }
+
+        report["files"].push_back(runFile(file, options));
+    }
+
+    if (const auto output = program.present("--output")) {
+        std::ofstream stream(*output);
+        if (!stream) {
+            spdlog::error("Failed to open file for writing: {}", *output);
+            return 1;
+        }
+
+        stream << report.dump(4) << '\n';
+    } else {
+        std::cout << report.dump(4) << '\n';
+    }
+
+    return 0;
+}
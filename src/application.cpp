@@ -1,6 +1,7 @@
 #include "application.h"
 #include "fonts/IconsFontAwesome6.h"
 #include "imgui/extensions.h"
+#include "util/allocation_counter.h"
 
 #include <SDL3/SDL.h>
 #include <GL/glew.h>
@@ -13,6 +14,7 @@
 #include <spdlog/spdlog.h>
 #include <nlohmann/json.hpp>
 #include <chrono>
+#include <cinttypes>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -153,12 +155,20 @@ int Application::run(int argc, char** argv) {
     }
 
     std::chrono::time_point<std::chrono::high_resolution_clock> lastFrame = std::chrono::high_resolution_clock::now();
+    u64 frameStartAllocations = AllocationCounter::getCount();
 
     while (m_running) {
         const auto now = std::chrono::high_resolution_clock::now();
         const auto delta = std::chrono::duration<float>(now - lastFrame).count();
         m_deltaTime = delta;
 
+        // Nothing from the last frame uses the arena anymore, resetting it may grow it and allocate once more
+        m_frameArena.reset();
+
+        const u64 allocations = AllocationCounter::getCount();
+        m_frameAllocations = allocations - frameStartAllocations;
+        frameStartAllocations = allocations;
+
         pollEvents();
 
         m_editor->updateParticles(delta);
@@ -755,6 +765,8 @@ void Application::renderPerformanceWindow() {
         ImGui::Text("FPS: %.1f", ImGui::GetIO().Framerate);
         ImGui::Text("Delta Time: %.3f ms", m_deltaTime * 1000.0f);
         ImGui::Text("Frame Time: %.3f ms", ImGui::GetIO().DeltaTime * 1000.0f);
+        ImGui::Text("Heap Allocations: %" PRIu64 " / frame", m_frameAllocations);
+        ImGui::Text("Frame Arena: %.1f / %.1f KiB", m_frameArena.getLastFrameUsage() / 1024.0f, m_frameArena.getCapacity() / 1024.0f);
 
         ImGui::SeparatorText("Current Editor");
         m_editor->renderStats();
@@ -3,6 +3,7 @@
 #include "application_settings.h"
 #include "editor/editor.h"
 #include "editor/project_manager.h"
+#include "util/frame_arena.h"
 
 #include <argparse/argparse.hpp>
 #include <SDL3/SDL_events.h>
@@ -29,6 +30,11 @@ public:
         return m_editor.get();
     }
 
+    // Scratch memory for the current frame, released at the start of the next one
+    FrameArena& getFrameArena() {
+        return m_frameArena;
+    }
+
     static std::string openFile();
     static std::string saveFile(const std::string& default_path = {});
     static std::string openDirectory(const char* title = nullptr);
@@ -76,6 +82,9 @@ private:
 
     bool m_performanceWindowOpen = false;
     float m_deltaTime = 0.0f;
+
+    FrameArena m_frameArena{ 1024 * 1024 }; // Grows on its own if frames need more
+    u64 m_frameAllocations = 0; // Heap allocations during the last full frame
 };
 
 inline Application* g_application = nullptr;
@@ -209,3 +209,53 @@ CameraParams Camera::getParams() const {
         getUp()
     };
 }
+
+Frustum::Frustum(const glm::mat4& viewProj) {
+    // Gribb/Hartmann: every plane is the sum or difference of the last row and one of the others
+    const auto row = [&](int i) {
+        return glm::vec4(viewProj[0][i], viewProj[1][i], viewProj[2][i], viewProj[3][i]);
+    };
+
+    planes[0] = row(3) + row(0); // left
+    planes[1] = row(3) - row(0); // right
+    planes[2] = row(3) + row(1); // bottom
+    planes[3] = row(3) - row(1); // top
+    planes[4] = row(3) + row(2); // near
+    planes[5] = row(3) - row(2); // far
+
+    for (auto& plane : planes) {
+        plane /= glm::length(glm::vec3(plane));
+    }
+}
+
+bool Frustum::intersectsSphere(const glm::vec3& center, f32 radius) const {
+    for (const auto& plane : planes) {
+        if (glm::dot(glm::vec3(plane), center) + plane.w < -radius) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+Frustum::Test Frustum::testBox(const glm::vec3& min, const glm::vec3& max) const {
+    Test result = Test::Inside;
+
+    for (const auto& plane : planes) {
+        const glm::vec3 normal = plane;
+
+        // Corners furthest along and against the plane normal
+        const glm::vec3 positive = glm::mix(min, max, glm::greaterThanEqual(normal, glm::vec3(0)));
+        const glm::vec3 negative = glm::mix(max, min, glm::greaterThanEqual(normal, glm::vec3(0)));
+
+        if (glm::dot(normal, positive) + plane.w < 0.0f) {
+            return Test::Outside;
+        }
+
+        if (glm::dot(normal, negative) + plane.w < 0.0f) {
+            result = Test::Intersecting;
+        }
+    }
+
+    return result;
+}
@@ -14,6 +14,22 @@ struct CameraParams {
     glm::vec3 up;
 };
 
+// The six planes of a view frustum, normals point inwards
+struct Frustum {
+    enum class Test {
+        Outside,
+        Intersecting,
+        Inside
+    };
+
+    explicit Frustum(const glm::mat4& viewProj);
+
+    bool intersectsSphere(const glm::vec3& center, f32 radius) const;
+    Test testBox(const glm::vec3& min, const glm::vec3& max) const;
+
+    glm::vec4 planes[6];
+};
+
 enum class CameraProjection {
     Perspective,
     Orthographic
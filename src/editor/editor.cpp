@@ -6,6 +6,7 @@
 #include "fonts/IconsFontAwesome6.h"
 #include "imgui/extensions.h"
 #include "spl/spl_resource.h"
+#include "gfx/gl_texture.h"
 
 #include <array>
 #include <cinttypes>
@@ -173,7 +174,8 @@ void Editor::renderParticles() {
         return;
     }
 
-    std::vector<Renderer*> renderers = { m_gridRenderer.get() };
+    std::pmr::vector<Renderer*> renderers(&g_application->getFrameArena());
+    renderers.push_back(m_gridRenderer.get());
 
     renderDebugShapes(editor, renderers);
     editor->renderParticles(renderers);
@@ -229,7 +231,7 @@ void Editor::renderStats() {
 
     const auto activeParticles = system.getParticleCount();
     const auto maxParticles = system.getMaxParticles();
-    const auto fraction = static_cast<float>(activeParticles) / maxParticles;
+    const auto fraction = std::min(static_cast<float>(activeParticles) / maxParticles, 1.0f);
     const auto particleText = fmt::format("Particles: {}/{}", activeParticles, maxParticles);
 
     constexpr auto colorLow = glm::vec4(0.0f, 1.0f, 0.0f, 1.0f);
@@ -241,6 +243,8 @@ void Editor::renderStats() {
     ImGui::PopStyleColor();
     
     ImGui::Text("Active Emitters: %" PRIu64, system.getEmitters().size());
+    ImGui::Text("Awake Emitters: %u", system.getAwakeEmitterCount());
+    ImGui::Text("Denied Spawns: %" PRIu64, system.getDeniedSpawns());
 }
 
 void Editor::openPicker() {
@@ -261,17 +265,6 @@ void Editor::updateParticles(float deltaTime) {
         return;
     }
 
-    for (auto& task : m_emitterTasks) {
-        const auto now = std::chrono::steady_clock::now();
-        if (task.editorID == editor->getUniqueID() && m_timeScale * (now - task.time) >= task.interval) {
-            editor->getParticleSystem().addEmitter(
-                editor->getArchive().getResources()[task.resourceIndex], 
-                false
-            );
-            task.time = now;
-        }
-    }
-    
     editor->updateParticles(deltaTime * m_timeScale);
 }
 
@@ -337,8 +330,15 @@ void Editor::loadConfig(const nlohmann::json& config) {
     m_settings.collisionPlaneBounceColor = loadVec4(settings, "collisionPlaneBounceColor", m_settingsDefault.collisionPlaneBounceColor);
     m_settings.collisionPlaneKillColor = loadVec4(settings, "collisionPlaneKillColor", m_settingsDefault.collisionPlaneKillColor);
     m_settings.maxParticles = settings.value("maxParticles", m_settingsDefault.maxParticles);
+    m_settings.updateThreads = settings.value("updateThreads", m_settingsDefault.updateThreads);
+    m_settings.fixedTimestep = settings.value("fixedTimestep", m_settingsDefault.fixedTimestep);
+    m_settings.prewarmLoopedEmitters = settings.value("prewarmLoopedEmitters", m_settingsDefault.prewarmLoopedEmitters);
+    m_settings.frameBudget = settings.value("frameBudget", m_settingsDefault.frameBudget);
+    m_settings.budgetPolicy = glm::clamp(settings.value("budgetPolicy", m_settingsDefault.budgetPolicy), 0, 2);
     m_settings.useFixedDsResolution = settings.value("useFixedDsResolution", m_settingsDefault.useFixedDsResolution);
     m_settings.fixedDsResolutionScale = settings.value("fixedDsResolutionScale", m_settingsDefault.fixedDsResolutionScale);
+
+    updateThreadCount();
 }
 
 void Editor::saveConfig(nlohmann::json& config) const {
@@ -355,6 +355,11 @@ void Editor::saveConfig(nlohmann::json& config) const {
         { "collisionPlaneBounceColor", saveVec4(m_settings.collisionPlaneBounceColor) },
         { "collisionPlaneKillColor", saveVec4(m_settings.collisionPlaneKillColor) },
         { "maxParticles", m_settings.maxParticles },
+        { "updateThreads", m_settings.updateThreads },
+        { "fixedTimestep", m_settings.fixedTimestep },
+        { "prewarmLoopedEmitters", m_settings.prewarmLoopedEmitters },
+        { "frameBudget", m_settings.frameBudget },
+        { "budgetPolicy", m_settings.budgetPolicy },
         { "useFixedDsResolution", m_settings.useFixedDsResolution },
         { "fixedDsResolutionScale", m_settings.fixedDsResolutionScale }
     });
@@ -412,18 +417,19 @@ void Editor::playEmitterAction(EmitterSpawnType spawnType) {
         return;
     }
 
-    editor->getParticleSystem().addEmitter(
-        editor->getArchive().getResource(resourceIndex),
-        spawnType == EmitterSpawnType::Looped
-    );
+    const auto& resource = editor->getArchive().getResource(resourceIndex);
+    if (spawnType == EmitterSpawnType::Looped && m_settings.prewarmLoopedEmitters) {
+        // One emitter lifetime plus the life of its last particles reaches the steady state
+        constexpr f32 maxPrewarmTime = 30.0f;
+        const f32 prewarmTime = resource.header.emitterLifeTime + resource.header.particleLifeTime;
+        editor->getParticleSystem().addEmitterPrewarmed(resource, glm::clamp(prewarmTime, 0.0f, maxPrewarmTime));
+    } else {
+        editor->getParticleSystem().addEmitter(resource, spawnType == EmitterSpawnType::Looped);
+    }
 
     if (spawnType == EmitterSpawnType::Interval) {
-        m_emitterTasks.emplace_back(
-            resourceIndex,
-            std::chrono::steady_clock::now(),
-            std::chrono::duration<float>(m_emitterInterval),
-            editor->getUniqueID()
-        );
+        // Runs on simulation time, so the interval follows time scaling and pausing
+        editor->getParticleSystem().addSpawner(resource, m_emitterInterval);
     }
 }
 
@@ -434,9 +440,6 @@ void Editor::killEmitters() {
     }
 
     editor->getParticleSystem().killAllEmitters();
-    std::erase_if(m_emitterTasks, [id = editor->getUniqueID()](const auto& task) {
-        return task.editorID == id;
-    });
 }
 
 void Editor::resetCamera() {
@@ -910,6 +913,8 @@ void Editor::renderResourceEditor() {
                 killEmitters();
             }
 
+            renderTimeline(editor->getParticleSystem());
+
             //if (ImGui::RedButton("Kill Emitters")) {
             //    killEmitters();
             //}
@@ -953,6 +958,36 @@ void Editor::renderResourceEditor() {
     m_activeEditor.reset();
 }
 
+void Editor::renderTimeline(ParticleSystem& system) {
+    if (!system.hasHistory()) {
+        return;
+    }
+
+    if (ImGui::Button(ICON_FA_BACKWARD_STEP) && system.getStep() > 0) {
+        system.seek(system.getStep() - 1);
+    }
+
+    ImGui::SameLine();
+    if (ImGui::Button(ICON_FA_FORWARD_STEP)) {
+        system.seek(system.getStep() + 1);
+    }
+
+    ImGui::SameLine();
+    u64 step = system.getStep();
+    const u64 first = system.getHistoryStart();
+    const u64 last = system.getHistoryEnd();
+
+    ImGui::SetNextItemWidth(ImGui::GetContentRegionAvail().x);
+    if (ImGui::SliderScalar("##Timeline", ImGuiDataType_U64, &step, &first, &last, "Frame %" PRIu64)) {
+        system.seek(step);
+    }
+
+    if (ImGui::IsItemHovered()) {
+        ImGui::SetTooltip("Scrub through the recent simulation history.\n"
+                          "Set the time scale to 0 to stay on a frame.");
+    }
+}
+
 void Editor::renderSettings() {
     ImGui::PushStyleVar(ImGuiStyleVar_WindowBorderSize, 1.0f);
     ImGui::PushOverrideID(m_settingsWindowId);
@@ -965,9 +1000,61 @@ void Editor::renderSettings() {
         ImGui::TextDisabled("(?)");
         if (ImGui::IsItemHovered()) {
             ImGui::SetTooltip("The maximum number of particles that can be processed/rendered at once per editor.\n"
+                              "Changing it keeps all running emitters alive.\n"
                               "Note that games using SPL usually have a limit of around 1000.");
         }
 
+        constexpr u32 minThreads = 1;
+        const u32 maxThreads = std::max(std::thread::hardware_concurrency(), minThreads);
+        ImGui::SliderScalar("Update Threads", ImGuiDataType_U32, &m_settings.updateThreads, &minThreads, &maxThreads);
+        m_settings.updateThreads = glm::clamp(m_settings.updateThreads, 1u, maxThreads);
+        ImGui::SameLine();
+        ImGui::TextDisabled("(?)");
+        if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip("The number of threads used to update emitters.\n"
+                              "Only helps with many emitters alive at once, the simulation result is the same either way.");
+        }
+
+        ImGui::Checkbox("Fixed Timestep", &m_settings.fixedTimestep);
+        ImGui::SameLine();
+        ImGui::TextDisabled("(?)");
+        if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip("If enabled, particles are simulated at the native 30 FPS of SPL files\n"
+                              "and smoothly interpolated in between, independent of the display refresh rate.\n"
+                              "If disabled, particles are simulated once per rendered frame.");
+        }
+
+        ImGui::Checkbox("Prewarm Looped Emitters", &m_settings.prewarmLoopedEmitters);
+        ImGui::SameLine();
+        ImGui::TextDisabled("(?)");
+        if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip("If enabled, looped emitters are simulated ahead in the background\n"
+                              "and appear already filled with particles, as if they had been running for a while.");
+        }
+
+        ImGui::SliderFloat("Frame Budget", &m_settings.frameBudget, 0.0f, 16.0f, m_settings.frameBudget > 0.0f ? "%.1f ms" : "Unlimited");
+        m_settings.frameBudget = std::max(m_settings.frameBudget, 0.0f);
+        ImGui::SameLine();
+        ImGui::TextDisabled("(?)");
+        if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip("Time per simulation step spent updating emitters.\n"
+                              "Emitters that don't fit are updated on a later step and catch up on the time they missed,\n"
+                              "off-screen emitters are deferred first. Every emitter still updates at least every %u steps.\n"
+                              "Keeps the frame time flat with many emitters, at the cost of reproducible results.",
+                              (u32)ParticleSystem::MAX_UPDATE_INTERVAL);
+        }
+
+        constexpr const char* budgetPolicies[] = { "First Come", "Fair", "Priority" };
+        ImGui::Combo("Budget Policy", &m_settings.budgetPolicy, budgetPolicies, IM_ARRAYSIZE(budgetPolicies));
+        ImGui::SameLine();
+        ImGui::TextDisabled("(?)");
+        if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip("How the particle budget is shared when emitters want more particles than are left.\n"
+                              "First Come: emitters spawn in update order, later emitters may get nothing.\n"
+                              "Fair: every emitter gets an equal share, emission slows down evenly.\n"
+                              "Priority: every emitter gets a share proportional to its priority.");
+        }
+
         ImGui::SeparatorText("Colors");
         ImGui::ColorEdit4("Active Emitter Color", glm::value_ptr(m_settings.activeEmitterColor));
         ImGui::ColorEdit4("Edited Emitter Color", glm::value_ptr(m_settings.editedEmitterColor));
@@ -1005,6 +1092,22 @@ void Editor::renderSettings() {
                 updateMaxParticles(); // Apply the setting to all open editors
             }
 
+            if (m_settings.updateThreads != m_settingsBackup.updateThreads) {
+                updateThreadCount();
+            }
+
+            if (m_settings.fixedTimestep != m_settingsBackup.fixedTimestep) {
+                updateFixedTimestep();
+            }
+
+            if (m_settings.frameBudget != m_settingsBackup.frameBudget) {
+                updateFrameBudget();
+            }
+
+            if (m_settings.budgetPolicy != m_settingsBackup.budgetPolicy) {
+                updateBudgetPolicy();
+            }
+
             m_settingsBackup = m_settings;
             m_settingsOpen = false;
             closedThroughButton = true;
@@ -2141,7 +2244,7 @@ void Editor::helpPopup(std::string_view text) const {
     }
 }
 
-void Editor::renderDebugShapes(const std::shared_ptr<EditorInstance>& editor, std::vector<Renderer*>& renderers) {
+void Editor::renderDebugShapes(const std::shared_ptr<EditorInstance>& editor, std::pmr::vector<Renderer*>& renderers) {
     const auto& archive = editor->getArchive();
     const auto& resources = archive.getResources();
 
@@ -2219,7 +2322,7 @@ void Editor::renderDebugShapes(const std::shared_ptr<EditorInstance>& editor, st
 
     // Render emitters
     for (const auto& emitter : editor->getParticleSystem().getEmitters()) {
-        const auto resource = emitter->getResource();
+        const auto resource = emitter.getResource();
         glm::vec3 axis;
 
         switch (resource->header.flags.emissionAxis) {
@@ -2233,28 +2336,28 @@ void Editor::renderDebugShapes(const std::shared_ptr<EditorInstance>& editor, st
             axis = { 0, 0, 1 };
             break;
         case SPLEmissionAxis::Emitter:
-            axis = emitter->getAxis();
+            axis = emitter.getAxis();
             break;
         }
 
         const glm::vec4& color = m_settings.activeEmitterColor;
         switch (resource->header.flags.emissionType) {
         case SPLEmissionType::Point:
-            m_debugRenderer->addBox(emitter->getPosition(), { 0.2f, 0.2f, 0.2f }, color);
+            m_debugRenderer->addBox(emitter.getPosition(), { 0.2f, 0.2f, 0.2f }, color);
             break;
         case SPLEmissionType::SphereSurface: [[fallthrough]];
         case SPLEmissionType::Sphere:
-            m_debugRenderer->addSphere(emitter->getPosition(), resource->header.radius, color);
+            m_debugRenderer->addSphere(emitter.getPosition(), resource->header.radius, color);
             break;
         case SPLEmissionType::CircleBorder: [[fallthrough]];
         case SPLEmissionType::CircleBorderUniform: [[fallthrough]];
         case SPLEmissionType::Circle:
-            m_debugRenderer->addCircle(emitter->getPosition(), axis, resource->header.radius, color);
+            m_debugRenderer->addCircle(emitter.getPosition(), axis, resource->header.radius, color);
             break;
         case SPLEmissionType::CylinderSurface: [[fallthrough]];
         case SPLEmissionType::Cylinder:
             m_debugRenderer->addCylinder(
-                emitter->getPosition(),
+                emitter.getPosition(),
                 axis,
                 resource->header.length,
                 resource->header.radius,
@@ -2263,7 +2366,7 @@ void Editor::renderDebugShapes(const std::shared_ptr<EditorInstance>& editor, st
             break;
         case SPLEmissionType::HemisphereSurface: [[fallthrough]];
         case SPLEmissionType::Hemisphere:
-            m_debugRenderer->addHemisphere(emitter->getPosition(), axis, resource->header.radius, color);
+            m_debugRenderer->addHemisphere(emitter.getPosition(), axis, resource->header.radius, color);
             break;
         }
     }
@@ -2276,6 +2379,43 @@ void Editor::updateMaxParticles() {
     }
 }
 
+void Editor::updateThreadCount() {
+    const auto editors = g_projectManager->getOpenEditors();
+    for (const auto& editor : editors) {
+        editor->setThreadPool(nullptr);
+    }
+
+    m_threadPool.reset();
+    if (m_settings.updateThreads > 1) {
+        m_threadPool = std::make_unique<ThreadPool>(m_settings.updateThreads - 1);
+    }
+
+    for (const auto& editor : editors) {
+        editor->setThreadPool(m_threadPool.get());
+    }
+}
+
+void Editor::updateFixedTimestep() {
+    const auto editors = g_projectManager->getOpenEditors();
+    for (const auto& editor : editors) {
+        editor->setFixedTimestep(m_settings.fixedTimestep);
+    }
+}
+
+void Editor::updateFrameBudget() {
+    const auto editors = g_projectManager->getOpenEditors();
+    for (const auto& editor : editors) {
+        editor->setUpdateBudget(m_settings.frameBudget / 1000.0f);
+    }
+}
+
+void Editor::updateBudgetPolicy() {
+    const auto editors = g_projectManager->getOpenEditors();
+    for (const auto& editor : editors) {
+        editor->setBudgetPolicy((BudgetPolicy)m_settings.budgetPolicy);
+    }
+}
+
 void Editor::openTempTexture(const std::filesystem::path& path, size_t destIndex) {
     constexpr auto isPowerOf2 = [](s32 value) {
         return (value & (value - 1)) == 0;
@@ -2463,7 +2603,7 @@ void Editor::importTempTexture() {
 
     discardTempTexture();
 
-    activeEditor->getParticleSystem().getRenderer().setTextures(textures);
+    activeEditor->getParticleRenderer().setTextures(textures);
 }
 
 void Editor::ensureValidSelection(const std::shared_ptr<EditorInstance>& editor) {
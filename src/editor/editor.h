@@ -4,13 +4,15 @@
 #include "editor_settings.h"
 #include "debug_renderer.h"
 #include "grid_renderer.h"
+#include "gfx/gl_texture.h"
+#include "util/thread_pool.h"
 #include "types.h"
 
 #include <imgui.h>
 #include <nlohmann/json.hpp>
 
 #include <array>
-#include <chrono>
+#include <memory_resource>
 #include <unordered_map>
 #include <vector>
 
@@ -58,10 +60,16 @@ public:
         return m_settings;
     }
 
+    // Shared by all editors for particle updates, nullptr if updates run on the main thread only
+    ThreadPool* getThreadPool() const {
+        return m_threadPool.get();
+    }
+
 private:
     void renderResourcePicker();
     void renderTextureManager();
     void renderResourceEditor();
+    void renderTimeline(ParticleSystem& system);
     void renderSettings();
 
     void updateRenderSettings();
@@ -85,9 +93,13 @@ private:
 
     void helpPopup(std::string_view text) const;
 
-    void renderDebugShapes(const std::shared_ptr<EditorInstance>& editor, std::vector<Renderer*>& renderers);
+    void renderDebugShapes(const std::shared_ptr<EditorInstance>& editor, std::pmr::vector<Renderer*>& renderers);
 
     void updateMaxParticles();
+    void updateThreadCount();
+    void updateFixedTimestep();
+    void updateFrameBudget();
+    void updateBudgetPolicy();
 
     void openTempTexture(const std::filesystem::path& path, size_t destIndex = -1);
     void discardTempTexture();
@@ -133,6 +145,8 @@ private:
     EditorSettings m_settingsBackup;
     EditorSettings m_settingsDefault;
 
+    std::unique_ptr<ThreadPool> m_threadPool;
+
     EmitterSpawnType m_emitterSpawnType = EmitterSpawnType::SingleShot;
     float m_emitterInterval = 1.0f; // seconds
 
@@ -155,13 +169,4 @@ private:
     std::shared_ptr<GridRenderer> m_gridRenderer;
     std::unique_ptr<DebugRenderer> m_debugRenderer;
     std::shared_ptr<GridRenderer> m_collisionGridRenderer;
-
-    struct EmitterSpawnTask {
-        u64 resourceIndex;
-        std::chrono::time_point<std::chrono::steady_clock> time;
-        std::chrono::duration<float> interval;
-        u64 editorID;
-    };
-
-    std::vector<EmitterSpawnTask> m_emitterTasks;
 };
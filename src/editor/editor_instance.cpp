@@ -2,6 +2,7 @@
 #include "application.h"
 #include "project_manager.h"
 #include "spl/spl_random.h"
+#include "gfx/gl_texture.h"
 #include "gfx/gl_util.h"
 
 #include <GL/glew.h>
@@ -13,10 +14,17 @@
 
 EditorInstance::EditorInstance(const std::filesystem::path& path, bool isTemp)
     : m_path(path), m_archive(path)
-    , m_particleSystem(g_application->getEditor()->getSettings().maxParticles, m_archive.getTextures())
+    , m_particleSystem(g_application->getEditor()->getSettings().maxParticles)
+    , m_particleRenderer(g_application->getEditor()->getSettings().maxParticles, m_archive.getTextures(), &g_application->getFrameArena())
     , m_camera(glm::radians(45.0f), { 800, 800 }, 1.0f, 500.0f), m_isTemp(isTemp) {
     m_uniqueID = SPLRandom::nextU64();
     m_updateProj = true;
+    GLTexture::createTextures(m_archive.getTextures());
+    m_particleSystem.setThreadPool(g_application->getEditor()->getThreadPool());
+    m_particleSystem.setFixedTimestep(g_application->getEditor()->getSettings().fixedTimestep);
+    m_particleSystem.setBudgetPolicy((BudgetPolicy)g_application->getEditor()->getSettings().budgetPolicy);
+    m_particleSystem.setUpdateBudget(g_application->getEditor()->getSettings().frameBudget / 1000.0f);
+    m_particleSystem.setSnapshotInterval(ParticleSystem::DEFAULT_SNAPSHOT_INTERVAL);
     notifyResourceChanged(0);
 
     m_camera.setProjection(
@@ -27,10 +35,17 @@ EditorInstance::EditorInstance(const std::filesystem::path& path, bool isTemp)
 }
 
 EditorInstance::EditorInstance(bool isTemp)
-    : m_archive(), m_particleSystem(g_application->getEditor()->getSettings().maxParticles, m_archive.getTextures())
+    : m_archive(), m_particleSystem(g_application->getEditor()->getSettings().maxParticles)
+    , m_particleRenderer(g_application->getEditor()->getSettings().maxParticles, m_archive.getTextures(), &g_application->getFrameArena())
     , m_camera(glm::radians(45.0f), { 800, 800 }, 1.0f, 500.0f), m_isTemp(isTemp) {
     m_uniqueID = SPLRandom::nextU64();
     m_updateProj = true;
+    GLTexture::createTextures(m_archive.getTextures());
+    m_particleSystem.setThreadPool(g_application->getEditor()->getThreadPool());
+    m_particleSystem.setFixedTimestep(g_application->getEditor()->getSettings().fixedTimestep);
+    m_particleSystem.setBudgetPolicy((BudgetPolicy)g_application->getEditor()->getSettings().budgetPolicy);
+    m_particleSystem.setUpdateBudget(g_application->getEditor()->getSettings().frameBudget / 1000.0f);
+    m_particleSystem.setSnapshotInterval(ParticleSystem::DEFAULT_SNAPSHOT_INTERVAL);
 
     g_application->getEditor()->selectResource(m_uniqueID, -1);
     notifyResourceChanged(-1);
@@ -94,7 +109,7 @@ std::pair<bool, bool> EditorInstance::render() {
     return { open, active };
 }
 
-void EditorInstance::renderParticles(const std::vector<Renderer*>& renderers) {
+void EditorInstance::renderParticles(std::span<Renderer* const> renderers) {
     auto renderSize = m_size;
 
     const auto& settings = g_application->getEditor()->getSettings();
@@ -125,12 +140,24 @@ void EditorInstance::renderParticles(const std::vector<Renderer*>& renderers) {
         renderer->render(m_camera.getView(), m_camera.getProj());
     }
 
-    m_particleSystem.render(m_camera.getParams());
+    m_particleRenderer.render(m_particleSystem, m_camera.getParams());
 
     m_viewport.unbind();
 }
 
 void EditorInstance::updateParticles(float deltaTime) {
+    if (m_animationsDirty) {
+        for (auto& resource : m_archive.getResources()) {
+            resource.bakeAnimations();
+        }
+
+        // Steps recorded after this point were simulated with the old values,
+        // and sleeping emitters computed their wake-up times from them
+        m_particleSystem.truncateHistory();
+        m_particleSystem.wakeAll();
+        m_animationsDirty = false;
+    }
+
     m_camera.update();
     m_particleSystem.update(deltaTime);
 }
@@ -170,6 +197,7 @@ bool EditorInstance::valueChanged(bool changed) {
 
     if (changed) {
         m_isTemp = false; // Changing anything inside a "temporary" editor will make it persistent
+        m_animationsDirty = true;
     }
 
     m_modified |= changed;
@@ -257,6 +285,7 @@ void EditorInstance::saveAs(const std::filesystem::path& path) {
 EditorActionType EditorInstance::undo() {
     if (m_history.canUndo()) {
         m_modified = true;
+        m_animationsDirty = true;
         return m_history.undo(m_archive.getResources());
     }
 
@@ -266,6 +295,7 @@ EditorActionType EditorInstance::undo() {
 EditorActionType EditorInstance::redo() {
     if (m_history.canRedo()) {
         m_modified = true;
+        m_animationsDirty = true;
         return m_history.redo(m_archive.getResources());
     }
 
@@ -1,12 +1,14 @@
 #pragma once
 
 #include <filesystem>
+#include <span>
 #include <utility> // std::pair
 #include <SDL3/SDL_events.h>
 
 #include "camera.h"
 #include "gfx/gl_viewport.h"
-#include "particle_system.h"
+#include "particle_renderer.h"
+#include "spl/particle_system.h"
 #include "renderer.h"
 #include "editor_history.h"
 #include "spl/spl_archive.h"
@@ -18,7 +20,7 @@ public:
     EditorInstance(bool isTemp = false);
 
     std::pair<bool, bool> render();
-    void renderParticles(const std::vector<Renderer*>& renderers);
+    void renderParticles(std::span<Renderer* const> renderers);
     void updateParticles(float deltaTime);
     void handleEvent(const SDL_Event& event);
 
@@ -31,6 +33,23 @@ public:
 
     void setMaxParticles(u32 maxParticles) {
         m_particleSystem.setMaxParticles(maxParticles);
+        m_particleRenderer.setMaxInstances(maxParticles);
+    }
+
+    void setThreadPool(ThreadPool* threadPool) {
+        m_particleSystem.setThreadPool(threadPool);
+    }
+
+    void setFixedTimestep(bool enabled) {
+        m_particleSystem.setFixedTimestep(enabled);
+    }
+
+    void setUpdateBudget(f32 seconds) {
+        m_particleSystem.setUpdateBudget(seconds);
+    }
+
+    void setBudgetPolicy(BudgetPolicy policy) {
+        m_particleSystem.setBudgetPolicy(policy);
     }
 
     void makePermanent() {
@@ -77,6 +96,10 @@ public:
         return m_particleSystem;
     }
 
+    ParticleRenderer& getParticleRenderer() {
+        return m_particleRenderer;
+    }
+
     Camera& getCamera() {
         return m_camera;
     }
@@ -90,6 +113,7 @@ private:
     SPLArchive m_archive;
     GLViewport m_viewport = GLViewport({ 800, 600 });
     ParticleSystem m_particleSystem;
+    ParticleRenderer m_particleRenderer;
     Camera m_camera;
     EditorHistory m_history;
 
@@ -100,5 +124,6 @@ private:
     bool m_updateProj;
     bool m_isTemp = false;
     bool m_modified = false; // Has the file been modified?
+    bool m_animationsDirty = false; // Do the resources' animation tables need to be rebaked?
     u64 m_uniqueID;
 };
@@ -20,6 +20,11 @@ struct EditorSettings {
     glm::vec4 collisionPlaneBounceColor = { 0.0f, 1.0f, 0.0f, 0.3f }; // Color of the collision plane (bounce mode)
     glm::vec4 collisionPlaneKillColor = { 1.0f, 0.0f, 0.0f, 0.3f }; // Color of the collision plane (kill mode)
     u32 maxParticles = 1000; // Maximum number of particles to process
+    u32 updateThreads = 1; // Number of threads used to update particles, 1 = update on the main thread only
+    bool fixedTimestep = true; // Simulate at the native 30 Hz of the format and interpolate in between
+    bool prewarmLoopedEmitters = true; // Start looped emitters in their steady state instead of empty
+    f32 frameBudget = 0.0f; // Milliseconds per simulation step spent updating emitters, 0 = no limit
+    int budgetPolicy = 0; // Maps to BudgetPolicy, how the particle budget is shared between emitters when it runs short
 };
 
 
@@ -1,9 +1,14 @@
 #include "particle_renderer.h"
+#include "spl/particle_system.h"
+#include "camera.h"
+#include "gfx/gl_texture.h"
 #include "gfx/gl_util.h"
 
 #include <algorithm>
 #include <GL/glew.h>
+#include <glm/ext/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include <glm/gtx/norm.hpp>
 #include <numeric>
 #include <ranges>
 #include <spdlog/spdlog.h>
@@ -67,14 +72,9 @@ void main() {
 
 }
 
-ParticleRenderer::ParticleRenderer(u32 maxInstances, std::span<const SPLTexture> textures)
+ParticleRenderer::ParticleRenderer(u32 maxInstances, std::span<const SPLTexture> textures, std::pmr::memory_resource* frameMemory)
     : m_maxInstances(maxInstances), m_shader(s_lineVertexShader, s_fragmentShader)
-    , m_textures(textures), m_view(1.0f), m_proj(1.0f) {
-
-    for (u32 i = 0; i < textures.size(); i++) {
-        m_particles.emplace_back();
-        m_particles.back().reserve(maxInstances / textures.size()); // Rough distribution for fewer reallocations
-    }
+    , m_textures(textures), m_view(1.0f), m_proj(1.0f), m_frameMemory(frameMemory) {
 
     // Create VAO
     glCall(glGenVertexArrays(1, &m_vao));
@@ -127,8 +127,17 @@ ParticleRenderer::ParticleRenderer(u32 maxInstances, std::span<const SPLTexture>
 }
 
 void ParticleRenderer::begin(const glm::mat4& view, const glm::mat4& proj) {
-    for (auto& particles : m_particles) {
-        particles.clear();
+    if (m_particles.size() != m_textures.size()) {
+        m_particles.clear();
+        m_lastCounts.assign(m_textures.size(), 0);
+        for (u32 i = 0; i < m_textures.size(); i++) {
+            m_particles.emplace_back(m_frameMemory);
+        }
+    }
+
+    // The lists start out with room for as many instances as their texture drew last frame
+    for (u32 i = 0; i < m_particles.size(); i++) {
+        m_particles[i].reserve(m_lastCounts[i]);
     }
 
     m_isRendering = true;
@@ -160,6 +169,12 @@ void ParticleRenderer::end() {
     glCall(glBindVertexArray(0));
     m_shader.unbind();
 
+    // The storage goes away with the frame memory, so the lists must not hold on to it past the frame
+    for (u32 i = 0; i < m_particles.size(); i++) {
+        m_lastCounts[i] = m_particles[i].size();
+        m_particles[i] = std::pmr::vector<ParticleInstance>(m_frameMemory);
+    }
+
     m_isRendering = false;
 }
 
@@ -183,11 +198,7 @@ void ParticleRenderer::setTextures(std::span<const SPLTexture> textures) {
     }
 
     m_textures = textures;
-    m_particles.clear();
-
-    for (u32 i = 0; i < textures.size(); i++) {
-        m_particles.emplace_back().reserve(m_maxInstances / textures.size()); // Rough distribution for fewer reallocations
-    }
+    m_particles.clear(); // Recreated by the next begin
 }
 
 void ParticleRenderer::setMaxInstances(u32 maxInstances) {
@@ -199,3 +210,173 @@ void ParticleRenderer::setMaxInstances(u32 maxInstances) {
     glCall(glBindBuffer(GL_ARRAY_BUFFER, m_transformVbo));
     glCall(glBufferData(GL_ARRAY_BUFFER, m_maxInstances * sizeof(ParticleInstance), nullptr, GL_DYNAMIC_DRAW));
 }
+
+void ParticleRenderer::render(ParticleSystem& system, const CameraParams& params) {
+    begin(params.view, params.proj);
+
+    const Frustum frustum(params.proj * params.view);
+
+    for (auto& emitter : system.getEmitters()) {
+        if (emitter.isRenderingDisabled()) {
+            emitter.setVisible(false);
+            continue;
+        }
+
+        // Without particles there are no bounds yet, the emitter counts as visible until it has some
+        if (emitter.getParticles().empty() && emitter.getChildParticles().empty()) {
+            emitter.setVisible(true);
+            continue;
+        }
+
+        const auto& resource = *emitter.getResource();
+        const f32 interpolation = system.getInterpolation(emitter);
+
+        // Emitters entirely out of view are skipped, particles are only tested one by one if the emitter straddles the edge.
+        // Directional billboards are placed relative to the view rather than the world, so they are always drawn.
+        const Frustum* cullFrustum = nullptr;
+        if (resource.header.flags.drawType == SPLDrawType::Billboard) {
+            const auto& bounds = emitter.getBounds();
+            const auto test = frustum.testBox(bounds.min, bounds.max);
+            emitter.setVisible(test != Frustum::Test::Outside);
+            if (test == Frustum::Test::Outside) {
+                continue;
+            }
+
+            if (test == Frustum::Test::Intersecting) {
+                cullFrustum = &frustum;
+            }
+        }
+
+        // Newest particles are drawn first
+        const auto texCoords = emitter.getTexCoords();
+        for (const auto block : std::views::reverse(emitter.getParticles().getBlocks())) {
+            for (u32 i = block->count; i-- > 0;) {
+                submitParticle(*block, i, params, resource, texCoords.s, texCoords.t, interpolation, cullFrustum);
+            }
+        }
+
+        const auto childTexCoords = emitter.getChildTexCoords();
+        for (const auto block : std::views::reverse(emitter.getChildParticles().getBlocks())) {
+            for (u32 i = block->count; i-- > 0;) {
+                submitParticle(*block, i, params, resource, childTexCoords.s, childTexCoords.t, interpolation, cullFrustum);
+            }
+        }
+    }
+
+    end();
+}
+
+void ParticleRenderer::submitParticle(const SPLParticleBlock& block, u32 index, const CameraParams& params, const SPLResource& resource, f32 s, f32 t, f32 interpolation, const Frustum* frustum) {
+    switch (resource.header.flags.drawType) {
+    case SPLDrawType::Billboard:
+        submitBillboard(block, index, params, resource, s, t, interpolation, frustum);
+        break;
+    case SPLDrawType::DirectionalBillboard:
+        submitDirectionalBillboard(block, index, params, resource, s, t, interpolation);
+        break;
+    case SPLDrawType::Polygon:
+        break;
+    case SPLDrawType::DirectionalPolygon:
+        break;
+    case SPLDrawType::DirectionalPolygonCenter:
+        break;
+    }
+}
+
+void ParticleRenderer::submitBillboard(const SPLParticleBlock& block, u32 index, const CameraParams& params, const SPLResource& resource, f32 s, f32 t, f32 interpolation, const Frustum* frustum) {
+    const f32 animScale = block.animScale[index];
+    glm::vec3 scale = { block.baseScale[index] * resource.header.aspectRatio, block.baseScale[index], 1 };
+
+    switch (resource.header.misc.scaleAnimDir) {
+    case SPLScaleAnimDir::XY:
+        scale.x *= animScale;
+        scale.y *= animScale;
+        break;
+    case SPLScaleAnimDir::X:
+        scale.x *= animScale;
+        break;
+    case SPLScaleAnimDir::Y:
+        scale.y *= animScale;
+        break;
+    }
+
+    const auto particlePos = block.getWorldPosition(index, interpolation);
+    if (frustum && !frustum->intersectsSphere(particlePos, glm::length(glm::vec2(scale)))) {
+        return;
+    }
+
+    const auto viewAxis = glm::normalize(params.pos - particlePos);
+
+    auto orientation = glm::mat4(1);
+    orientation[0] = glm::vec4(params.right, 0);
+    orientation[1] = glm::vec4(params.up, 0);
+    orientation[2] = glm::vec4(viewAxis, 0);
+
+    const auto transform = glm::translate(glm::mat4(1), particlePos)
+        * orientation
+        * glm::rotate(glm::mat4(1), glm::mix(block.prevRotation[index], block.rotation[index], interpolation), { 0, 0, 1 })
+        * glm::scale(glm::mat4(1), scale);
+
+    submit(block.texture[index], {
+        .color = { block.color[index], block.baseAlpha[index] * block.animAlpha[index] },
+        .transform = transform,
+        .texCoords = {
+            { 0, t },
+            { s, t },
+            { s, 0 },
+            { 0, 0 }
+        }
+    });
+}
+
+void ParticleRenderer::submitDirectionalBillboard(const SPLParticleBlock& block, u32 index, const CameraParams& params, const SPLResource& resource, f32 s, f32 t, f32 interpolation) {
+    const f32 animScale = block.animScale[index];
+    const glm::vec3& velocity = block.velocity[index];
+    glm::vec3 scale = { block.baseScale[index] * resource.header.aspectRatio, block.baseScale[index], 1 };
+
+    switch (resource.header.misc.scaleAnimDir) {
+    case SPLScaleAnimDir::XY:
+        scale.x *= animScale;
+        scale.y *= animScale;
+        break;
+    case SPLScaleAnimDir::X:
+        scale.x *= animScale;
+        break;
+    case SPLScaleAnimDir::Y:
+        scale.y *= animScale;
+        break;
+    }
+
+    glm::vec3 dir = glm::cross(velocity, params.forward);
+    if (glm::length2(dir) < 0.0001f) {
+        return;
+    }
+    
+    dir = glm::normalize(dir);
+    const auto velDir = glm::normalize(velocity);
+
+    f32 dot = glm::dot(velDir, -params.forward);
+    if (dot < 0.0f) { // Particle is behind the camera
+        dot = -dot;
+    }
+
+    scale.y *= (1.0f - dot) * resource.header.misc.dbbScale + 1.0f;
+    const auto pos = glm::vec4(block.getWorldPosition(index, interpolation), 1) * params.view;
+    const auto transform = glm::mat4(
+        dir.x * scale.x, dir.y * scale.x, 0, 0,
+        -dir.y * scale.y, dir.x * scale.y, 0, 0,
+        0, 0, 1, 0,
+        pos.x, pos.y, pos.z, 1
+    );
+
+    submit(block.texture[index], {
+        .color = { block.color[index], block.baseAlpha[index] * block.animAlpha[index] },
+        .transform = transform,
+        .texCoords = {
+            { 0, 0 },
+            { s, 0 },
+            { s, t },
+            { 0, t }
+        }
+    });
+}
@@ -3,6 +3,7 @@
 #include "types.h"
 #include "spl/spl_particle.h"
 
+#include <memory_resource>
 #include <span>
 #include <unordered_map>
 #include <vector>
@@ -17,9 +18,17 @@ struct ParticleInstance {
     glm::vec2 texCoords[4];
 };
 
+class ParticleSystem;
+struct CameraParams;
+struct Frustum;
+
 class ParticleRenderer {
 public:
-    explicit ParticleRenderer(u32 maxInstances, std::span<const SPLTexture> textures);
+    // Instance lists are allocated from `frameMemory` between begin and end, it can be released after end
+    ParticleRenderer(u32 maxInstances, std::span<const SPLTexture> textures, std::pmr::memory_resource* frameMemory);
+
+    // Draws every particle of the system that is in view of the camera, and tells emitters whether they were visible
+    void render(ParticleSystem& system, const CameraParams& params);
 
     void begin(const glm::mat4& view, const glm::mat4& proj);
     void end();
@@ -31,6 +40,12 @@ public:
     void setTextures(std::span<const SPLTexture> textures);
     void setMaxInstances(u32 maxInstances);
 
+private:
+    // A non-null frustum culls particles outside of it
+    void submitParticle(const SPLParticleBlock& block, u32 index, const CameraParams& params, const SPLResource& resource, f32 s, f32 t, f32 interpolation, const Frustum* frustum);
+    void submitBillboard(const SPLParticleBlock& block, u32 index, const CameraParams& params, const SPLResource& resource, f32 s, f32 t, f32 interpolation, const Frustum* frustum);
+    void submitDirectionalBillboard(const SPLParticleBlock& block, u32 index, const CameraParams& params, const SPLResource& resource, f32 s, f32 t, f32 interpolation);
+
 private:
     u32 m_maxInstances;
     u32 m_vao;
@@ -48,5 +63,7 @@ private:
     bool m_isRendering = false;
 
     size_t m_particleCount = 0;
-    std::vector<std::vector<ParticleInstance>> m_particles;
+    std::pmr::memory_resource* m_frameMemory;
+    std::vector<std::pmr::vector<ParticleInstance>> m_particles; // One list per texture, empty outside of begin/end
+    std::vector<size_t> m_lastCounts; // Instances drawn with each texture in the last frame
 };
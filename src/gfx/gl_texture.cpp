@@ -100,13 +100,27 @@ void GLTexture::update(const void* rgba) {
     ));
 }
 
+void GLTexture::createTextures(std::span<SPLTexture> textures) {
+    for (auto& texture : textures) {
+        if (!texture.glTexture && !texture.param.useSharedTexture) {
+            texture.glTexture = std::make_shared<GLTexture>(texture);
+        }
+    }
+
+    for (auto& texture : textures) {
+        if (texture.param.useSharedTexture) {
+            texture.glTexture = textures[texture.param.sharedTexID].glTexture;
+        }
+    }
+}
+
 void GLTexture::createTexture(const SPLTexture& texture) {
 
     // Texture creation is a 2 step process. First the texture/palette data must be converted
     // to a format that OpenGL can understand (RGBA32). Then the texture will be uploaded to the GPU.
 
     // Step 1: Conversion
-    const auto textureData = toRGBA(texture);
+    const auto textureData = texture.convertToRGBA8888();
     const auto repeat = (TextureRepeat)texture.param.repeat;
 
     // Step 2: Upload to GPU
@@ -149,195 +163,3 @@ void GLTexture::createTexture(const SPLTexture& texture) {
 
     glCall(glBindTexture(GL_TEXTURE_2D, 0));
 }
-
-std::vector<u8> GLTexture::toRGBA(const SPLTexture& texture) {
-    switch ((TextureFormat)texture.param.format) {
-    case TextureFormat::A3I5:
-        return convertA3I5(
-            texture.textureData.data(),
-            (const GXRgba*)texture.paletteData.data(),
-            texture.width,
-            texture.height,
-            texture.paletteData.size()
-        );
-    case TextureFormat::Palette4:
-        return convertPalette4(
-            texture.textureData.data(),
-            (const GXRgba*)texture.paletteData.data(),
-            texture.width,
-            texture.height,
-            texture.paletteData.size(),
-            texture.param.palColor0Transparent
-        );
-    case TextureFormat::Palette16:
-        return convertPalette16(
-            texture.textureData.data(),
-            (const GXRgba*)texture.paletteData.data(),
-            texture.width,
-            texture.height,
-            texture.paletteData.size(),
-            texture.param.palColor0Transparent
-        );
-    case TextureFormat::Palette256:
-        return convertPalette256(
-            texture.textureData.data(),
-            (const GXRgba*)texture.paletteData.data(),
-            texture.width,
-            texture.height,
-            texture.paletteData.size(),
-            texture.param.palColor0Transparent
-        );
-    case TextureFormat::Comp4x4:
-        return convertComp4x4(
-            texture.textureData.data(),
-            (const GXRgba*)texture.paletteData.data(),
-            texture.width,
-            texture.height,
-            texture.paletteData.size()
-        );
-    case TextureFormat::A5I3:
-        return convertA5I3(
-            texture.textureData.data(),
-            (const GXRgba*)texture.paletteData.data(),
-            texture.width,
-            texture.height,
-            texture.paletteData.size()
-        );
-    case TextureFormat::Direct:
-        return convertDirect(
-            (const GXRgba*)texture.textureData.data(),
-            texture.width,
-            texture.height
-        );
-    default:
-        spdlog::error("Unsupported texture format: {}", (int)texture.param.format);
-        return {};
-    }
-}
-
-std::vector<u8> GLTexture::convertA3I5(const u8* tex, const GXRgba* pal, size_t width, size_t height, size_t palSize) {
-    std::vector<u8> texture(width * height * 4);
-    const auto pixels = reinterpret_cast<const PixelA3I5*>(tex);
-
-    for (size_t i = 0; i < width * height; i++) {
-        GXRgba color = pal[pixels[i].color];
-
-        texture[i * 4 + 0] = color.r8();
-        texture[i * 4 + 1] = color.g8();
-        texture[i * 4 + 2] = color.b8();
-        texture[i * 4 + 3] = pixels[i].getAlpha();
-    }
-
-    return texture;
-}
-
-std::vector<u8> GLTexture::convertPalette4(const u8* tex, const GXRgba* pal, size_t width, size_t height, size_t palSize, bool color0Transparent) {
-    std::vector<u8> texture(width * height * 4);
-    const auto pixels = tex;
-    const u8 alpha0 = color0Transparent ? 0 : 0xFF;
-
-    for (size_t i = 0; i < width * height; i += 4) {
-        const u8 pixel = pixels[i / 4];
-
-        u8 index = pixel & 0x3;
-        texture[i * 4 + 0] = pal[index].r8();
-        texture[i * 4 + 1] = pal[index].g8();
-        texture[i * 4 + 2] = pal[index].b8();
-        texture[i * 4 + 3] = index == 0 ? alpha0 : 0xFF;
-
-        index = (pixel >> 2) & 0x3;
-        texture[i * 4 + 4] = pal[index].r8();
-        texture[i * 4 + 5] = pal[index].g8();
-        texture[i * 4 + 6] = pal[index].b8();
-        texture[i * 4 + 7] = index == 0 ? alpha0 : 0xFF;
-
-        index = (pixel >> 4) & 0x3;
-        texture[i * 4 + 8] = pal[index].r8();
-        texture[i * 4 + 9] = pal[index].g8();
-        texture[i * 4 + 10] = pal[index].b8();
-        texture[i * 4 + 11] = index == 0 ? alpha0 : 0xFF;
-
-        index = (pixel >> 6) & 0x3;
-        texture[i * 4 + 12] = pal[index].r8();
-        texture[i * 4 + 13] = pal[index].g8();
-        texture[i * 4 + 14] = pal[index].b8();
-        texture[i * 4 + 15] = index == 0 ? alpha0 : 0xFF;
-    }
-
-    return texture;
-}
-
-std::vector<u8> GLTexture::convertPalette16(const u8* tex, const GXRgba* pal, size_t width, size_t height, size_t palSize, bool color0Transparent) {
-    std::vector<u8> texture(width * height * 4);
-    const auto pixels = tex;
-    const u8 alpha0 = color0Transparent ? 0 : 0xFF;
-
-    for (size_t i = 0; i < width * height; i += 2) {
-        const u8 pixel = pixels[i / 2];
-
-        u8 index = pixel & 0xF;
-        texture[i * 4 + 0] = pal[index].r8();
-        texture[i * 4 + 1] = pal[index].g8();
-        texture[i * 4 + 2] = pal[index].b8();
-        texture[i * 4 + 3] = index == 0 ? alpha0 : 0xFF;
-
-        index = (pixel >> 4) & 0xF;
-        texture[i * 4 + 4] = pal[index].r;
-        texture[i * 4 + 5] = pal[index].g;
-        texture[i * 4 + 6] = pal[index].b;
-        texture[i * 4 + 7] = index == 0 ? alpha0 : 0xFF;
-    }
-
-    return texture;
-}
-
-std::vector<u8> GLTexture::convertPalette256(const u8* tex, const GXRgba* pal, size_t width, size_t height, size_t palSize, bool color0Transparent) {
-    std::vector<u8> texture(width * height * 4);
-    const auto pixels = tex;
-    const u8 alpha0 = color0Transparent ? 0 : 0xFF;
-
-    for (size_t i = 0; i < width * height; i++) {
-        const u8 pixel = pixels[i];
-        const u8 index = pixel;
-        texture[i * 4 + 0] = pal[index].r8();
-        texture[i * 4 + 1] = pal[index].g8();
-        texture[i * 4 + 2] = pal[index].b8();
-        texture[i * 4 + 3] = index == 0 ? alpha0 : 0xFF;
-    }
-
-    return texture;
-}
-
-std::vector<u8> GLTexture::convertComp4x4(const u8* tex, const GXRgba* pal, size_t width, size_t height, size_t palSize) {
-    spdlog::warn("GLTexture::convertComp4x4 not implemented");
-    return {};
-}
-
-std::vector<u8> GLTexture::convertA5I3(const u8* tex, const GXRgba* pal, size_t width, size_t height, size_t palSize) {
-    std::vector<u8> texture(width * height * 4);
-    const auto pixels = reinterpret_cast<const PixelA5I3*>(tex);
-
-    for (size_t i = 0; i < width * height; i++) {
-        GXRgba color = pal[pixels[i].color];
-
-        texture[i * 4 + 0] = color.r8();
-        texture[i * 4 + 1] = color.g8();
-        texture[i * 4 + 2] = color.b8();
-        texture[i * 4 + 3] = pixels[i].getAlpha();
-    }
-
-    return texture;
-}
-
-std::vector<u8> GLTexture::convertDirect(const GXRgba* tex, size_t width, size_t height) {
-    std::vector<u8> texture(width * height * 4);
-
-    for (size_t i = 0; i < width * height; i++) {
-        texture[i * 4 + 0] = tex[i].r8();
-        texture[i * 4 + 1] = tex[i].g8();
-        texture[i * 4 + 2] = tex[i].b8();
-        texture[i * 4 + 3] = tex[i].a ? 0xFF : 0x00;
-    }
-
-    return texture;
-}
@@ -0,0 +1,201 @@
+#include "particle_pool.h"
+#include "util/thread_pool.h"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <new>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+u8* reserveMemory(size_t size) {
+#ifdef _WIN32
+    return (u8*)VirtualAlloc(nullptr, size, MEM_RESERVE, PAGE_NOACCESS);
+#else
+    void* ptr = mmap(nullptr, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    return ptr == MAP_FAILED ? nullptr : (u8*)ptr;
+#endif
+}
+
+bool commitMemory(u8* ptr, size_t size) {
+#ifdef _WIN32
+    return VirtualAlloc(ptr, size, MEM_COMMIT, PAGE_READWRITE) != nullptr;
+#else
+    return mprotect(ptr, size, PROT_READ | PROT_WRITE) == 0;
+#endif
+}
+
+void releaseMemory(u8* ptr, size_t size) {
+#ifdef _WIN32
+    VirtualFree(ptr, 0, MEM_RELEASE);
+#else
+    munmap(ptr, size);
+#endif
+}
+
+size_t getPageSize() {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwPageSize;
+#else
+    return (size_t)sysconf(_SC_PAGESIZE);
+#endif
+}
+
+}
+
+ParticlePool::ParticlePool(u32 maxBlocks) : m_maxBlocks(std::min(maxBlocks, MAX_BLOCKS)) {
+    m_base = reserveMemory(getReservedBytes());
+    if (!m_base) {
+        spdlog::error("Failed to reserve {} bytes for the particle pool", getReservedBytes());
+    }
+}
+
+ParticlePool::~ParticlePool() {
+    if (m_base) {
+        releaseMemory(m_base, getReservedBytes());
+    }
+}
+
+SPLParticleBlock* ParticlePool::allocate() {
+    u32 index;
+    if (const auto cache = getCache()) {
+        if (cache->count == 0) {
+            refill(*cache);
+        }
+
+        index = cache->count > 0 ? cache->blocks[--cache->count] : INVALID_INDEX;
+    } else {
+        std::lock_guard lock(m_mutex);
+        index = allocateShared();
+    }
+
+    if (index == INVALID_INDEX) {
+        return nullptr;
+    }
+
+    m_usedBlocks.fetch_add(1, std::memory_order_relaxed);
+    return getBlock(index);
+}
+
+void ParticlePool::free(SPLParticleBlock* block) {
+    m_usedBlocks.fetch_sub(1, std::memory_order_relaxed);
+
+    if (const auto cache = getCache()) {
+        if (cache->count == CACHE_SIZE) {
+            flush(*cache, CACHE_SIZE / 2);
+        }
+
+        cache->blocks[cache->count++] = getIndex(block);
+    } else {
+        std::lock_guard lock(m_mutex);
+        freeShared(getIndex(block));
+    }
+}
+
+void ParticlePool::setThreadCount(u32 count) {
+    for (u32 i = 0; i < m_cacheCount; ++i) {
+        flush(m_caches[i], m_caches[i].count);
+    }
+
+    m_caches = count > 1 ? std::make_unique<ThreadCache[]>(count) : nullptr;
+    m_cacheCount = count > 1 ? count : 0;
+}
+
+ParticlePool::ThreadCache* ParticlePool::getCache() {
+    const u32 thread = ThreadPool::getCurrentThreadIndex();
+    return thread < m_cacheCount ? &m_caches[thread] : nullptr;
+}
+
+void ParticlePool::refill(ThreadCache& cache) {
+    std::lock_guard lock(m_mutex);
+
+    // Only take half, so freeing right after doesn't immediately hand everything back
+    while (cache.count < CACHE_SIZE / 2) {
+        const u32 index = allocateShared();
+        if (index == INVALID_INDEX) {
+            break;
+        }
+
+        cache.blocks[cache.count++] = index;
+    }
+}
+
+void ParticlePool::flush(ThreadCache& cache, u32 count) {
+    std::lock_guard lock(m_mutex);
+
+    // Return the oldest entries, the most recently freed blocks stay in the cache
+    for (u32 i = 0; i < count; ++i) {
+        freeShared(cache.blocks[i]);
+    }
+
+    std::copy(cache.blocks + count, cache.blocks + cache.count, cache.blocks);
+    cache.count -= count;
+}
+
+u32 ParticlePool::allocateShared() {
+    if (m_freeHead == INVALID_INDEX && !grow()) {
+        return INVALID_INDEX;
+    }
+
+    const u32 index = m_freeHead;
+    m_freeHead = getBlock(index)->next;
+
+    return index;
+}
+
+void ParticlePool::freeShared(u32 index) {
+    getBlock(index)->next = m_freeHead;
+    m_freeHead = index;
+}
+
+bool ParticlePool::grow() {
+    if (!m_base || m_committedBlocks >= m_maxBlocks) {
+        return false;
+    }
+
+    const u32 first = m_committedBlocks;
+    const u32 last = std::min(first + GROWTH_BLOCKS, m_maxBlocks);
+
+    // Blocks don't line up with pages, so round the range outwards.
+    // Committing a page twice is harmless.
+    const size_t pageSize = getPageSize();
+    const size_t begin = (size_t)first * sizeof(SPLParticleBlock) / pageSize * pageSize;
+    const size_t end = ((size_t)last * sizeof(SPLParticleBlock) + pageSize - 1) / pageSize * pageSize;
+
+    if (!commitMemory(m_base + begin, std::min(end, getReservedBytes()) - begin)) {
+        spdlog::error("Failed to commit memory for the particle pool");
+        return false;
+    }
+
+    // Link the new blocks so that the lowest index is handed out first
+    for (u32 i = last; i-- > first;) {
+        const auto block = new (getBlock(i)) SPLParticleBlock();
+        block->next = m_freeHead;
+        m_freeHead = i;
+    }
+
+    m_committedBlocks = last;
+    return true;
+}
+
+size_t ParticlePool::getReservedBytes() const {
+    return (size_t)m_maxBlocks * sizeof(SPLParticleBlock);
+}
+
+SPLParticleBlock* ParticlePool::getBlock(u32 index) const {
+    return (SPLParticleBlock*)(m_base + (size_t)index * sizeof(SPLParticleBlock));
+}
+
+u32 ParticlePool::getIndex(const SPLParticleBlock* block) const {
+    return (u32)(block - getBlock(0));
+}
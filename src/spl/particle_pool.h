@@ -0,0 +1,76 @@
+#pragma once
+
+#include "spl_particle.h"
+#include "types.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+
+// Backing storage for particle blocks.
+// A large range of address space is reserved up front and committed in chunks as the pool grows,
+// so blocks never move and capacity can be raised at runtime without touching live particles.
+// Free blocks are linked through SPLParticleBlock::next by index and reused LIFO, so the most
+// recently freed (and most likely cached) block is handed out first.
+// Each thread of the update thread pool gets a small private cache of free blocks in front of the
+// shared list, so concurrent emitter updates only take the lock once every few dozen blocks.
+class ParticlePool {
+public:
+    // Upper bound on the number of particles a single pool can ever hold
+    static constexpr u32 MAX_PARTICLES = 1 << 24;
+    static constexpr u32 MAX_BLOCKS = MAX_PARTICLES / SPLParticleBlock::CAPACITY;
+
+    // Reserves address space for `maxBlocks` blocks, pools that are known to stay small can reserve less
+    explicit ParticlePool(u32 maxBlocks = MAX_BLOCKS);
+    ~ParticlePool();
+
+    ParticlePool(const ParticlePool&) = delete;
+    ParticlePool& operator=(const ParticlePool&) = delete;
+
+    // Returns nullptr only if the reserved address range is exhausted
+    SPLParticleBlock* allocate();
+    void free(SPLParticleBlock* block);
+
+    // Sets the number of threads (as numbered by ThreadPool::getCurrentThreadIndex) that allocate concurrently.
+    // Must not be called while any of them is allocating.
+    void setThreadCount(u32 count);
+
+    u32 getCommittedBlocks() const { return m_committedBlocks; }
+    u32 getUsedBlocks() const { return m_usedBlocks.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr u32 CACHE_SIZE = 32;
+
+    struct alignas(64) ThreadCache {
+        u32 count = 0;
+        u32 blocks[CACHE_SIZE];
+    };
+
+    ThreadCache* getCache();
+    void refill(ThreadCache& cache);
+    void flush(ThreadCache& cache, u32 count);
+
+    u32 allocateShared();
+    void freeShared(u32 index);
+
+    bool grow();
+    size_t getReservedBytes() const;
+    SPLParticleBlock* getBlock(u32 index) const;
+    u32 getIndex(const SPLParticleBlock* block) const;
+
+private:
+    static constexpr u32 GROWTH_BLOCKS = 64; // Number of blocks committed at once
+    static constexpr u32 INVALID_INDEX = ~0u;
+
+    u8* m_base = nullptr;
+    u32 m_maxBlocks;
+    u32 m_committedBlocks = 0;
+    std::atomic<u32> m_usedBlocks = 0;
+
+    std::mutex m_mutex; // Guards the shared free list and growing
+    u32 m_freeHead = INVALID_INDEX;
+
+    std::unique_ptr<ThreadCache[]> m_caches;
+    u32 m_cacheCount = 0;
+};
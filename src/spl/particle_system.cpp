@@ -0,0 +1,687 @@
+#include "particle_system.h"
+#include "util/thread_pool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+
+ParticleSystem::ParticleSystem(u32 maxParticles) : ParticleSystem(maxParticles, ParticlePool::MAX_BLOCKS) {
+}
+
+ParticleSystem::ParticleSystem(u32 maxParticles, u32 poolBlocks)
+    : m_pool(poolBlocks), m_maxParticles(std::min(maxParticles, ParticlePool::MAX_PARTICLES)) {
+}
+
+ParticleSystem::~ParticleSystem() {
+    cancelPrewarmJobs();
+    m_snapshots.clear();
+    forceKillAllEmitters();
+}
+
+void ParticleSystem::update(float deltaTime) {
+    if (!m_prewarmJobs.empty()) {
+        finishPrewarmJobs();
+    }
+
+    if (!m_fixedTimestep) {
+        step(deltaTime);
+        m_interpolation = 1.0f;
+        return;
+    }
+
+    m_accumulator += deltaTime;
+
+    u32 steps = 0;
+    while (m_accumulator >= FIXED_TIMESTEP && steps < MAX_STEPS_PER_UPDATE) {
+        step(FIXED_TIMESTEP);
+        m_accumulator -= FIXED_TIMESTEP;
+        ++steps;
+    }
+
+    if (m_accumulator >= FIXED_TIMESTEP) {
+        m_accumulator = std::fmod(m_accumulator, FIXED_TIMESTEP);
+    }
+
+    m_interpolation = m_accumulator / FIXED_TIMESTEP;
+}
+
+void ParticleSystem::setFixedTimestep(bool enabled) {
+    m_fixedTimestep = enabled;
+    m_accumulator = 0.0f;
+    m_interpolation = 1.0f;
+    clearSnapshots();
+}
+
+void ParticleSystem::setSnapshotInterval(u32 interval) {
+    m_snapshotInterval = interval;
+    m_snapshots.resize(interval != 0 ? MAX_SNAPSHOTS : 0);
+    clearSnapshots();
+}
+
+bool ParticleSystem::seek(u64 target) {
+    if (!hasHistory() || target < getHistoryStart()) {
+        return false;
+    }
+
+    // Resume from the latest snapshot before the target, unless simulating on from the current state is shorter
+    for (u32 i = m_snapshotCount; i-- > 0;) {
+        const auto& snapshot = getSnapshot(i);
+        if (snapshot.step <= target) {
+            if (target < m_step || snapshot.step > m_step) {
+                restoreSnapshot(snapshot);
+            }
+
+            break;
+        }
+    }
+
+    while (m_step < target) {
+        step(FIXED_TIMESTEP);
+    }
+
+    m_accumulator = 0.0f;
+    m_interpolation = 1.0f;
+    return true;
+}
+
+void ParticleSystem::truncateHistory() {
+    // A snapshot of the current step may predate the change as well, it is retaken on the next step
+    while (m_snapshotCount > 0 && getSnapshot(m_snapshotCount - 1).step >= m_step) {
+        --m_snapshotCount;
+    }
+
+    m_historyEnd = m_step;
+}
+
+u64 ParticleSystem::getHistoryStart() const {
+    return m_snapshotCount > 0 ? m_snapshots[m_snapshotStart].step : m_step;
+}
+
+f32 ParticleSystem::getInterpolation(const SPLEmitter& emitter) const {
+    // Emitters skipped by the last step (paused or off-cycle) have no motion to interpolate
+    return emitter.m_lastStep == m_step ? m_interpolation : 1.0f;
+}
+
+void ParticleSystem::step(float deltaTime) {
+    if (hasHistory() && m_step % m_snapshotInterval == 0) {
+        takeSnapshot();
+    }
+
+    m_updateList.clear();
+    ++m_step;
+    m_time += deltaTime;
+    m_historyEnd = std::max(m_historyEnd, m_step);
+
+    // Sleeping emitters whose timers fire join this step, having skipped the time since they fell asleep
+    const f64 stepStart = m_time - deltaTime;
+    m_timers.advance(getTick(m_time), [&](const Timer& timer) { fireTimer(timer, stepStart); });
+
+    for (const auto handle : m_awake) {
+        auto& emitter = *m_emitters.get(handle);
+        const auto& header = emitter.m_resource->header;
+
+        if (!emitter.m_state.started && emitter.m_age >= header.startDelay) {
+            emitter.m_state.started = true;
+            emitter.m_age = 0;
+        }
+
+        if (emitter.m_state.paused) {
+            continue;
+        }
+
+        if (emitter.m_updateCycle != 0) {
+            // The DS update cycle: the emitter runs on every other step only, and isn't compensated for the skipped ones
+            if ((u8)m_cycle == emitter.m_updateCycle - 1) {
+                emitter.m_pendingTime = deltaTime;
+                emitter.m_lastStep = m_step;
+                m_updateList.push_back(&emitter);
+            }
+        } else {
+            emitter.m_pendingTime += deltaTime;
+            m_scheduleList.push_back(&emitter);
+        }
+    }
+
+    scheduleUpdates();
+
+    const bool independent = distributeBudget();
+    const auto start = std::chrono::steady_clock::now();
+
+    if (m_threadPool && m_updateList.size() > 1 && independent) {
+        m_threadPool->parallelFor((u32)m_updateList.size(), 1, [&](u32 i) {
+            m_updateList[i]->update(m_updateList[i]->m_pendingTime);
+            m_updateList[i]->m_pendingTime = 0.0f;
+        });
+    } else {
+        for (const auto emitter : m_updateList) {
+            emitter->update(emitter->m_pendingTime);
+            emitter->m_pendingTime = 0.0f;
+        }
+    }
+
+    if (m_updateBudget > 0.0f && m_scheduledCost > 0) {
+        const f64 elapsed = std::chrono::duration<f64>(std::chrono::steady_clock::now() - start).count();
+        const f64 cost = elapsed / m_scheduledCost;
+        m_updateCost = m_updateCost > 0.0 ? glm::mix(m_updateCost, cost, 0.1) : cost;
+    }
+
+    retireEmitters();
+
+    m_cycle = !m_cycle;
+}
+
+u64 ParticleSystem::getTick(f64 time) {
+    // Rounded down with some slack for accumulated float error, timers never fire late because of it
+    return (u64)(time / FIXED_TIMESTEP + 1e-6);
+}
+
+void ParticleSystem::fireTimer(const Timer& timer, f64 time) {
+    if (timer.spawner.generation != 0) {
+        const auto spawner = m_spawners.get(timer.spawner);
+        if (!spawner) {
+            return;
+        }
+
+        createEmitter(*spawner->resource, false);
+
+        // Spawns missed by a long step are dropped instead of all happening at once
+        spawner->nextTime = std::max(spawner->nextTime + spawner->interval, m_time);
+        scheduleSpawner(timer.spawner, *spawner);
+        return;
+    }
+
+    // The emitter may have died or been woken up early since the timer was set
+    const auto emitter = m_emitters.get(timer.emitter);
+    if (emitter && emitter->m_sleeping) {
+        wake(timer.emitter, *emitter, time);
+    }
+}
+
+void ParticleSystem::scheduleSpawner(SpawnerHandle handle, const EmitterSpawner& spawner) {
+    // Rounded up, unlike emitter wake-ups a spawn must not happen early
+    const u64 tick = (u64)std::ceil(spawner.nextTime / FIXED_TIMESTEP - 1e-6);
+    m_timers.schedule(tick, { .spawner = handle });
+}
+
+void ParticleSystem::sleep(EmitterHandle handle, SPLEmitter& emitter, f64 since, f32 seconds) {
+    emitter.m_sleeping = true;
+    emitter.m_sleepStart = since;
+
+    // Waking up a tick early only costs an idle update, emitters that never do anything again wait to be killed
+    if (std::isfinite(seconds)) {
+        m_timers.schedule(getTick(since + seconds), { .emitter = handle });
+    }
+}
+
+void ParticleSystem::wake(EmitterHandle handle, SPLEmitter& emitter, f64 time) {
+    // The emitter had no particles, so the skipped updates would only have aged it
+    const f32 missed = (f32)(time - emitter.m_sleepStart);
+    if (missed > 0.0f) {
+        emitter.m_age += missed;
+        emitter.m_emissionTimer += missed;
+    }
+
+    emitter.m_sleeping = false;
+    m_awake.push_back(handle);
+}
+
+void ParticleSystem::retireEmitters() {
+    constexpr f32 minSleep = MIN_SLEEP_TICKS * FIXED_TIMESTEP;
+
+    // Compacted in place, so the update order of the remaining emitters stays the same
+    size_t write = 0;
+    bool terminated = false;
+    for (const auto handle : m_awake) {
+        auto& emitter = *m_emitters.get(handle);
+
+        if (emitter.shouldTerminate()) {
+            terminated = true;
+            continue;
+        }
+
+        // Emitters owed time by the update budget or on the DS update cycle have to keep updating
+        if (!emitter.m_state.paused && emitter.m_pendingTime == 0.0f && emitter.m_updateCycle == 0) {
+            // Starting resets the age, so emitters in their start delay have to be awake by the time it ends
+            const f32 idle = emitter.m_state.started
+                ? emitter.getIdleTime()
+                : std::min(emitter.getIdleTime(), emitter.m_resource->header.startDelay - emitter.m_age);
+
+            if (idle >= minSleep) {
+                sleep(handle, emitter, m_time, idle);
+                continue;
+            }
+        }
+
+        m_awake[write++] = handle;
+    }
+
+    m_awake.resize(write);
+
+    // Removed in one pass once the awake list no longer points at them, the rest keep their creation order
+    if (terminated) {
+        m_emitters.eraseIf([](const SPLEmitter& emitter) { return !emitter.m_sleeping && emitter.shouldTerminate(); });
+    }
+}
+
+void ParticleSystem::scheduleUpdates() {
+    const auto getCost = [](const SPLEmitter& emitter) {
+        return emitter.m_particles.size() + emitter.m_childParticles.size() + 1;
+    };
+
+    m_scheduledCost = 0;
+
+    // Without a budget (or before the cost of an update is known) everything updates every step
+    if (m_updateBudget <= 0.0f || m_updateCost <= 0.0) {
+        for (const auto emitter : m_scheduleList) {
+            emitter->m_lastStep = m_step;
+            m_updateList.push_back(emitter);
+            m_scheduledCost += getCost(*emitter);
+        }
+
+        m_scheduleList.clear();
+        return;
+    }
+
+    // The longer an emitter has waited, the more urgent it gets. Low priority and off-screen emitters
+    // wait longer on average, but nothing waits more than MAX_UPDATE_INTERVAL steps.
+    const auto getUrgency = [this](const SPLEmitter& emitter) {
+        const f32 weight = std::max(emitter.m_priority, 0.0f) * (emitter.m_visible ? 1.0f : OFFSCREEN_WEIGHT);
+        return (f32)(m_step - emitter.m_lastStep) * weight;
+    };
+
+    const auto isOverdue = [this](const SPLEmitter& emitter) {
+        return m_step - emitter.m_lastStep >= MAX_UPDATE_INTERVAL;
+    };
+
+    // Ties are broken by storage order so the schedule doesn't depend on the sort implementation
+    std::sort(m_scheduleList.begin(), m_scheduleList.end(), [&](const SPLEmitter* a, const SPLEmitter* b) {
+        const bool overdueA = isOverdue(*a);
+        const bool overdueB = isOverdue(*b);
+        if (overdueA != overdueB) {
+            return overdueA;
+        }
+
+        const f32 urgencyA = getUrgency(*a);
+        const f32 urgencyB = getUrgency(*b);
+        return urgencyA != urgencyB ? urgencyA > urgencyB : a < b;
+    });
+
+    const u64 budget = std::max((u64)(m_updateBudget / m_updateCost), (u64)1);
+    for (const auto emitter : m_scheduleList) {
+        const u64 cost = getCost(*emitter);
+        if (m_scheduledCost + cost > budget && m_scheduledCost > 0 && !isOverdue(*emitter)) {
+            continue; // Skipped emitters keep their time and catch up with a longer step later
+        }
+
+        emitter->m_lastStep = m_step;
+        m_updateList.push_back(emitter);
+        m_scheduledCost += cost;
+    }
+
+    m_scheduleList.clear();
+}
+
+bool ParticleSystem::distributeBudget() {
+    m_spawnRequests.clear();
+
+    u64 requested = 0;
+    for (const auto emitter : m_updateList) {
+        const u32 request = emitter->getSpawnUpperBound();
+        m_spawnRequests.push_back(request);
+        requested += request;
+    }
+
+    const u32 count = m_particleCount.load(std::memory_order_relaxed);
+    const u32 available = count < m_maxParticles ? m_maxParticles - count : 0;
+
+    // The quick bounds can overestimate child spawns, only look at every parent when they don't fit
+    if (requested > available) {
+        requested = 0;
+        for (size_t i = 0; i < m_updateList.size(); ++i) {
+            m_spawnRequests[i] = m_updateList[i]->getExactSpawnUpperBound();
+            requested += m_spawnRequests[i];
+        }
+    }
+
+    // Emitters compete for the particle budget, with first come first serve earlier emitters win.
+    // Running in parallel only gives the same result if nobody can be denied a particle.
+    if (requested <= available || m_budgetPolicy == BudgetPolicy::FirstCome) {
+        for (const auto emitter : m_updateList) {
+            emitter->m_spawnQuota = std::numeric_limits<u32>::max();
+        }
+
+        return requested <= available;
+    }
+
+    for (const auto emitter : m_updateList) {
+        emitter->m_spawnQuota = 0;
+    }
+
+    const auto getWeight = [this](const SPLEmitter& emitter) {
+        return m_budgetPolicy == BudgetPolicy::Priority ? std::max(emitter.m_priority, 0.0f) : 1.0f;
+    };
+
+    // Hand out the budget in proportion to the weights. Emitters that need less than their share
+    // are capped at their request and the rest goes around again to the ones still wanting more.
+    u32 remaining = available;
+    while (remaining > 0) {
+        f64 totalWeight = 0.0;
+        for (size_t i = 0; i < m_updateList.size(); ++i) {
+            if (m_updateList[i]->m_spawnQuota < m_spawnRequests[i]) {
+                totalWeight += getWeight(*m_updateList[i]);
+            }
+        }
+
+        if (totalWeight <= 0.0) {
+            break;
+        }
+
+        u32 handedOut = 0;
+        for (size_t i = 0; i < m_updateList.size(); ++i) {
+            const auto emitter = m_updateList[i];
+            if (emitter->m_spawnQuota >= m_spawnRequests[i]) {
+                continue;
+            }
+
+            const u32 share = (u32)(remaining * (getWeight(*emitter) / totalWeight));
+            const u32 grant = std::min(share, m_spawnRequests[i] - emitter->m_spawnQuota);
+            emitter->m_spawnQuota += grant;
+            handedOut += grant;
+        }
+
+        if (handedOut == 0) {
+            break; // Only rounding leftovers remain
+        }
+
+        remaining -= handedOut;
+    }
+
+    // Leftovers from rounding (and anything zero-priority emitters can use) go out in update order
+    for (size_t i = 0; i < m_updateList.size() && remaining > 0; ++i) {
+        const auto emitter = m_updateList[i];
+        const u32 grant = std::min(remaining, m_spawnRequests[i] - emitter->m_spawnQuota);
+        emitter->m_spawnQuota += grant;
+        remaining -= grant;
+    }
+
+    // The quotas add up to at most the available budget, so no emitter can take another one's particles
+    return true;
+}
+
+void ParticleSystem::takeSnapshot() {
+    if (m_snapshotCount > 0 && getSnapshot(m_snapshotCount - 1).step >= m_step) {
+        return; // Already recorded while simulating this part of the history before
+    }
+
+    // When full, the oldest snapshot is overwritten, reusing its buffers
+    u32 index = m_snapshotCount;
+    if (m_snapshotCount == MAX_SNAPSHOTS) {
+        m_snapshotStart = (m_snapshotStart + 1) % MAX_SNAPSHOTS;
+        index = MAX_SNAPSHOTS - 1;
+    } else {
+        ++m_snapshotCount;
+    }
+
+    auto& snapshot = getSnapshot(index);
+    snapshot.step = m_step;
+    snapshot.time = m_time;
+    snapshot.cycle = m_cycle;
+    snapshot.streamCount = m_streamCount;
+
+    snapshot.layout = m_emitters.getLayout();
+    snapshot.awake = m_awake;
+    snapshot.spawners = m_spawners;
+    snapshot.timers = m_timers;
+
+    const auto emitters = m_emitters.values();
+    snapshot.emitters.resize(emitters.size());
+    for (size_t i = 0; i < emitters.size(); ++i) {
+        const auto& emitter = emitters[i];
+        auto& saved = snapshot.emitters[i];
+
+        saved.emitter.reset(new SPLEmitter(emitter));
+        emitter.m_particles.save(saved.particles);
+        emitter.m_childParticles.save(saved.childParticles);
+    }
+}
+
+void ParticleSystem::restoreSnapshot(const Snapshot& snapshot) {
+    // Emitters still prewarming were added to the timeline being left, they don't belong in the restored one
+    cancelPrewarmJobs();
+    forceKillAllEmitters();
+
+    m_step = snapshot.step;
+    m_time = snapshot.time;
+    m_cycle = snapshot.cycle;
+    m_streamCount = snapshot.streamCount;
+
+    m_emitters.assign(snapshot.layout, [&](u32 i) { return SPLEmitter(*snapshot.emitters[i].emitter); });
+    m_awake = snapshot.awake;
+    m_spawners = snapshot.spawners;
+    m_timers = snapshot.timers;
+
+    const auto emitters = m_emitters.values();
+    for (size_t i = 0; i < emitters.size(); ++i) {
+        const auto& saved = snapshot.emitters[i];
+        emitters[i].m_particles.restore(saved.particles);
+        emitters[i].m_childParticles.restore(saved.childParticles);
+    }
+}
+
+void ParticleSystem::clearSnapshots() {
+    for (auto& snapshot : m_snapshots) {
+        snapshot.emitters.clear();
+    }
+
+    m_snapshotStart = 0;
+    m_snapshotCount = 0;
+    m_historyEnd = m_step;
+}
+
+EmitterHandle ParticleSystem::addEmitter(const SPLResource& resource, bool looping) {
+    truncateHistory();
+
+    return createEmitter(resource, looping);
+}
+
+EmitterHandle ParticleSystem::createEmitter(const SPLResource& resource, bool looping) {
+    const auto handle = m_emitters.emplace(&resource, this, looping);
+    m_awake.push_back(handle);
+
+    return handle;
+}
+
+void ParticleSystem::prewarm(f32 seconds, f32 timestep) {
+    // Everything updates every step and no history is recorded for the skipped time
+    const f32 updateBudget = std::exchange(m_updateBudget, 0.0f);
+    const u32 snapshotInterval = std::exchange(m_snapshotInterval, 0);
+
+    const u32 steps = (u32)std::ceil(seconds / timestep);
+    for (u32 i = 0; i < steps && !m_cancelPrewarm.load(std::memory_order_relaxed); ++i) {
+        step(timestep);
+    }
+
+    m_updateBudget = updateBudget;
+    m_snapshotInterval = snapshotInterval;
+    m_accumulator = 0.0f;
+    m_interpolation = 1.0f;
+    clearSnapshots();
+}
+
+void ParticleSystem::addEmitterPrewarmed(const SPLResource& resource, f32 seconds) {
+    auto resourceCopy = std::make_unique<SPLResource>(resource.duplicate());
+
+    // The private system hands the emitter the random stream it would have gotten here.
+    // Its pool only reserves enough for the budget, the particle and child lists of its single emitter
+    // can each have a partially filled block at either end.
+    const u32 poolBlocks = (m_maxParticles + SPLParticleBlock::CAPACITY - 1) / SPLParticleBlock::CAPACITY + 4;
+    auto system = std::unique_ptr<ParticleSystem>(new ParticleSystem(m_maxParticles, poolBlocks));
+    system->m_seed = m_seed;
+    system->m_streamCount = m_streamCount++;
+    system->m_time = m_time;
+    system->addEmitter(*resourceCopy, true);
+
+    auto task = std::async(std::launch::async, [system = system.get(), seconds] {
+        system->prewarm(seconds);
+    });
+
+    m_prewarmJobs.push_back({ &resource, std::move(resourceCopy), std::move(system), std::move(task) });
+}
+
+void ParticleSystem::finishPrewarmJobs() {
+    std::vector<SPLParticleBlock> blocks;
+
+    std::erase_if(m_prewarmJobs, [&](PrewarmJob& job) {
+        if (job.task.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            return false;
+        }
+
+        job.task.get();
+        truncateHistory();
+
+        // The emitter moves over with its particles, which are copied into this system's pool
+        const f64 timeOffset = job.system->m_time - m_time;
+        for (const auto& prewarmed : job.system->m_emitters.values()) {
+            SPLEmitter emitter(prewarmed);
+            emitter.m_resource = job.resource;
+            emitter.m_system = this;
+            emitter.m_particles = SPLParticleList(this);
+            emitter.m_childParticles = SPLParticleList(this);
+            emitter.m_lastRandomApplication -= timeOffset;
+            emitter.m_lastStep = m_step;
+
+            const auto handle = m_emitters.emplace(std::move(emitter));
+            const auto adopted = m_emitters.get(handle);
+
+            if (adopted->m_sleeping) {
+                adopted->m_sleepStart -= timeOffset;
+                wake(handle, *adopted, m_time);
+            } else {
+                m_awake.push_back(handle);
+            }
+
+            prewarmed.m_particles.save(blocks);
+            adopted->m_particles.restore(blocks);
+            prewarmed.m_childParticles.save(blocks);
+            adopted->m_childParticles.restore(blocks);
+        }
+
+        return true;
+    });
+}
+
+void ParticleSystem::cancelPrewarmJobs() {
+    for (auto& job : m_prewarmJobs) {
+        job.system->m_cancelPrewarm = true;
+    }
+
+    // Destroying the futures waits for the tasks, which stop at their next step
+    m_prewarmJobs.clear();
+}
+
+SpawnerHandle ParticleSystem::addSpawner(const SPLResource& resource, f32 interval) {
+    truncateHistory();
+
+    const auto handle = m_spawners.emplace(&resource, interval, m_time + interval);
+    scheduleSpawner(handle, *m_spawners.get(handle));
+
+    return handle;
+}
+
+void ParticleSystem::removeSpawner(SpawnerHandle spawner) {
+    if (m_spawners.erase(spawner)) {
+        truncateHistory();
+    }
+}
+
+void ParticleSystem::wakeAll() {
+    // Their timers are left in the wheel and ignored when they fire
+    const auto emitters = m_emitters.values();
+    for (u32 i = 0; i < emitters.size(); ++i) {
+        if (emitters[i].m_sleeping) {
+            wake(m_emitters.getHandle(i), emitters[i], m_time);
+        }
+    }
+}
+
+void ParticleSystem::killEmitter(EmitterHandle emitter) {
+    if (const auto ptr = m_emitters.get(emitter)) {
+        truncateHistory();
+        ptr->m_state.terminate = true;
+
+        // Terminating emitters have to update once more to be removed
+        if (ptr->m_sleeping) {
+            wake(emitter, *ptr, m_time);
+        }
+    }
+}
+
+void ParticleSystem::killAllEmitters() {
+    // Usually followed by changes to the resources, which snapshots and prewarming emitters point into
+    cancelPrewarmJobs();
+    clearSnapshots();
+
+    m_spawners.clear();
+
+    for (auto& emitter : m_emitters.values()) {
+        emitter.m_state.terminate = true;
+    }
+
+    // Terminating emitters have to update once more to be removed
+    wakeAll();
+}
+
+bool ParticleSystem::allocateParticle() {
+    u32 count = m_particleCount.load(std::memory_order_relaxed);
+    do {
+        if (count >= m_maxParticles) {
+            return false;
+        }
+    } while (!m_particleCount.compare_exchange_weak(count, count + 1, std::memory_order_relaxed));
+
+    return true;
+}
+
+u32 ParticleSystem::allocateParticles(u32 count) {
+    u32 current = m_particleCount.load(std::memory_order_relaxed);
+    u32 granted;
+    do {
+        granted = current < m_maxParticles ? std::min(count, m_maxParticles - current) : 0;
+        if (granted == 0) {
+            return 0;
+        }
+    } while (!m_particleCount.compare_exchange_weak(current, current + granted, std::memory_order_relaxed));
+
+    return granted;
+}
+
+void ParticleSystem::freeParticles(u32 count) {
+    m_particleCount.fetch_sub(count, std::memory_order_relaxed);
+}
+
+SPLParticleBlock* ParticleSystem::allocateBlock() {
+    return m_pool.allocate();
+}
+
+void ParticleSystem::freeBlock(SPLParticleBlock* block) {
+    m_pool.free(block);
+}
+
+void ParticleSystem::setMaxParticles(u32 maxParticles) {
+    maxParticles = std::min(maxParticles, ParticlePool::MAX_PARTICLES);
+
+    m_maxParticles = maxParticles;
+}
+
+void ParticleSystem::setThreadPool(ThreadPool* threadPool) {
+    m_threadPool = threadPool;
+    m_pool.setThreadCount(threadPool ? threadPool->getWorkerCount() + 1 : 0);
+}
+
+void ParticleSystem::forceKillAllEmitters() {
+    m_emitters.clear();
+    m_awake.clear();
+}
@@ -0,0 +1,282 @@
+#pragma once
+
+#include "spl_archive.h"
+#include "spl_particle.h"
+#include "spl_random.h"
+#include "spl_emitter.h"
+#include "particle_pool.h"
+#include "util/slot_map.h"
+#include "util/timer_wheel.h"
+
+#include <glm/glm.hpp>
+
+#include <atomic>
+#include <future>
+#include <memory>
+#include <vector>
+
+class ThreadPool;
+
+// Refers to an emitter for as long as it lives, stale handles resolve to nullptr
+using EmitterHandle = SlotMap<SPLEmitter>::Handle;
+
+// Adds an emitter for a resource at a fixed interval of simulation time
+struct EmitterSpawner {
+    const SPLResource* resource;
+    f32 interval; // in seconds
+    f64 nextTime; // simulation time of the next spawn
+};
+
+using SpawnerHandle = SlotMap<EmitterSpawner>::Handle;
+
+// How the particle budget is shared when emitters want to spawn more particles than are left
+enum class BudgetPolicy : u8 {
+    FirstCome, // Emitters spawn in update order until the budget runs out, later emitters get nothing
+    Fair, // Every emitter gets an equal share
+    Priority, // Every emitter gets a share proportional to its priority
+};
+
+class ParticleSystem {
+public:
+    // Simulation only, particles are drawn by a ParticleRenderer
+    explicit ParticleSystem(u32 maxParticles);
+    ~ParticleSystem();
+
+    // Steps at the native rate of the format when the fixed timestep is enabled
+    static constexpr f32 FIXED_TIMESTEP = 1.0f / (f32)SPLArchive::SPL_FRAMES_PER_SECOND;
+
+    // Upper bound on catch-up steps per update, time beyond that is dropped so a stall can't snowball
+    static constexpr u32 MAX_STEPS_PER_UPDATE = 4;
+
+    // Prewarming trades accuracy for speed with steps twice as long as regular ones
+    static constexpr f32 PREWARM_TIMESTEP = FIXED_TIMESTEP * 2.0f;
+
+    void update(float deltaTime);
+
+    // In fixed timestep mode the simulation advances in steps of FIXED_TIMESTEP regardless of the frame rate,
+    // and particles are rendered interpolated between the last two steps
+    void setFixedTimestep(bool enabled);
+    bool isFixedTimestep() const { return m_fixedTimestep; }
+
+    // Snapshots are taken every second of simulation by default
+    static constexpr u32 DEFAULT_SNAPSHOT_INTERVAL = SPLArchive::SPL_FRAMES_PER_SECOND;
+    static constexpr u32 MAX_SNAPSHOTS = 32;
+
+    // Records a snapshot of the whole simulation every `interval` steps, so the history can be revisited with seek.
+    // Only used in fixed timestep mode, 0 disables snapshots.
+    void setSnapshotInterval(u32 interval);
+
+    // Moves the simulation to the target step by restoring the closest snapshot and simulating from there.
+    // Steps past the end of the history are simulated from the current state.
+    // Returns false if the step lies before the oldest snapshot.
+    bool seek(u64 target);
+
+    // Forgets the history after the current step, must be called whenever the simulation diverges from it
+    void truncateHistory();
+
+    bool hasHistory() const { return m_fixedTimestep && m_snapshotInterval != 0; }
+    u64 getHistoryStart() const;
+    u64 getHistoryEnd() const { return m_historyEnd; }
+    u64 getStep() const { return m_step; }
+
+    // Simulation time, in seconds. Only advances while the simulation steps, so it follows time scaling and pausing.
+    f64 getTime() const { return m_time; }
+
+    // How far rendering is between the previous and the current simulation step of an emitter, in [0, 1]
+    f32 getInterpolation(const SPLEmitter& emitter) const;
+
+    EmitterHandle addEmitter(const SPLResource& resource, bool looping = false);
+
+    // Simulates the whole system `seconds` ahead right away in steps of `timestep`, ignoring the update budget.
+    // Meant for headless runs that want to start from a steady state.
+    void prewarm(f32 seconds, f32 timestep = PREWARM_TIMESTEP);
+
+    // Adds a looping emitter that has already been running for `seconds`. The emitter is simulated on a background
+    // thread in a private system and joins this one in the first update after it is done, so it never shows up empty.
+    void addEmitterPrewarmed(const SPLResource& resource, f32 seconds);
+    bool isPrewarming() const { return !m_prewarmJobs.empty(); }
+
+    // Adds a new emitter for the resource every `interval` seconds of simulation time, the first one after `interval`.
+    // Spawners run until removed or until all emitters are killed.
+    SpawnerHandle addSpawner(const SPLResource& resource, f32 interval);
+    void removeSpawner(SpawnerHandle spawner);
+
+    // Wakes every sleeping emitter, must be called when resources change since sleepers were scheduled with
+    // the old start delays, emission intervals and life times. They go back to sleep after their next update.
+    void wakeAll();
+
+    void killEmitter(EmitterHandle emitter);
+    void killAllEmitters();
+
+    // Returns nullptr once the emitter has died. The pointer is only valid until emitters are added or removed.
+    SPLEmitter* getEmitter(EmitterHandle emitter) { return m_emitters.get(emitter); }
+    const SPLEmitter* getEmitter(EmitterHandle emitter) const { return m_emitters.get(emitter); }
+
+    // Reserves a single particle from the particle budget
+    bool allocateParticle();
+
+    // Reserves up to `count` particles, returns how many fit into the budget
+    u32 allocateParticles(u32 count);
+    void freeParticles(u32 count);
+
+    SPLParticleBlock* allocateBlock();
+    void freeBlock(SPLParticleBlock* block);
+
+    // Changes the particle budget. Live emitters and particles are kept,
+    // if the budget shrinks below the current count no new particles are spawned until enough have died.
+    void setMaxParticles(u32 maxParticles);
+    u32 getMaxParticles() const { return m_maxParticles; }
+    u32 getParticleCount() const { return m_particleCount.load(std::memory_order_relaxed); }
+
+    // Under budget pressure, Fair and Priority give every emitter a spawn quota for the step up front,
+    // so emission rates degrade evenly instead of starving the emitters that update last
+    void setBudgetPolicy(BudgetPolicy policy) { m_budgetPolicy = policy; }
+    BudgetPolicy getBudgetPolicy() const { return m_budgetPolicy; }
+
+    // Spawns denied by the budget or quotas since the system was created, summed over all emitters
+    u64 getDeniedSpawns() const { return m_deniedSpawns.load(std::memory_order_relaxed); }
+    void reportDeniedSpawns(u32 count) { m_deniedSpawns.fetch_add(count, std::memory_order_relaxed); }
+
+    // Limits the time spent updating emitters per step, in seconds, 0 updates every emitter every step.
+    // Emitters that don't fit are updated on a later step with the time they missed, favoring high priority
+    // and visible emitters. Since it depends on measured timings, a budget makes the simulation nondeterministic.
+    void setUpdateBudget(f32 seconds) { m_updateBudget = seconds; }
+    f32 getUpdateBudget() const { return m_updateBudget; }
+
+    // Emitters are updated at least every MAX_UPDATE_INTERVAL steps regardless of the budget
+    static constexpr u64 MAX_UPDATE_INTERVAL = 4;
+
+    // Off-screen emitters count this much less when choosing which emitters to update under a budget
+    static constexpr f32 OFFSCREEN_WEIGHT = 0.25f;
+
+    // Spreads emitter updates across the given thread pool, nullptr updates everything on the calling thread
+    void setThreadPool(ThreadPool* threadPool);
+    ThreadPool* getThreadPool() const { return m_threadPool; }
+
+    // Emitters get their random streams in creation order, so the same sequence of emitters
+    // always simulates the same way, independent of anything else using random numbers
+    SPLRandom::Generator createRandomStream() { return SPLRandom::Generator(m_seed, m_streamCount++); }
+
+    std::span<const SPLEmitter> getEmitters() const { return m_emitters.values(); }
+    std::span<SPLEmitter> getEmitters() { return m_emitters.values(); }
+
+    // Emitters that are updated every step. The rest have no particles to simulate and sleep until their next
+    // emission, loop restart or the end of their start delay, costing nothing until their timer fires.
+    u32 getAwakeEmitterCount() const { return (u32)m_awake.size(); }
+
+    // Emitters only go to sleep if they would otherwise update at least this many idle steps in a row
+    static constexpr u32 MIN_SLEEP_TICKS = 2;
+
+private:
+    // Wakes up a sleeping emitter, or runs a spawner if `spawner` is set. Stale timers are ignored when they fire.
+    struct Timer {
+        EmitterHandle emitter;
+        SpawnerHandle spawner;
+    };
+
+    struct Snapshot {
+        struct Emitter {
+            std::unique_ptr<SPLEmitter> emitter; // Copy of the emitter state without particles
+            std::vector<SPLParticleBlock> particles;
+            std::vector<SPLParticleBlock> childParticles;
+        };
+
+        u64 step;
+        f64 time;
+        bool cycle;
+        u64 streamCount;
+        SlotMap<SPLEmitter>::Layout layout; // Keeps handles valid across seeks
+        std::vector<Emitter> emitters;
+        std::vector<EmitterHandle> awake;
+        SlotMap<EmitterSpawner> spawners;
+        TimerWheel<Timer> timers;
+    };
+
+    // For private systems that never hold more than a few emitters, reserves a pool of `poolBlocks` blocks only
+    ParticleSystem(u32 maxParticles, u32 poolBlocks);
+
+    struct PrewarmJob {
+        const SPLResource* resource;
+        std::unique_ptr<SPLResource> resourceCopy; // Simulated instead of the original, which may be edited meanwhile
+        std::unique_ptr<ParticleSystem> system; // Only touched by the task until it finishes
+        std::future<void> task;
+    };
+
+    // Adds an emitter without touching the history, for spawns that are part of the simulation
+    EmitterHandle createEmitter(const SPLResource& resource, bool looping);
+
+    // Timers count in steps of FIXED_TIMESTEP, in every timestep mode
+    static u64 getTick(f64 time);
+
+    // `time` is the start of the current step, which emitters woken by the timer are simulated from
+    void fireTimer(const Timer& timer, f64 time);
+    void scheduleSpawner(SpawnerHandle handle, const EmitterSpawner& spawner);
+
+    // Stops updating the emitter from simulation time `since` on, for `seconds` or for good if that is infinite
+    void sleep(EmitterHandle handle, SPLEmitter& emitter, f64 since, f32 seconds);
+
+    // Catches up on the time the emitter slept through, up to `time`, and schedules it for updates again
+    void wake(EmitterHandle handle, SPLEmitter& emitter, f64 time);
+
+    // Removes dead emitters from the awake list and the system, and puts idle ones to sleep
+    void retireEmitters();
+
+    void forceKillAllEmitters();
+    void finishPrewarmJobs();
+    void cancelPrewarmJobs();
+    void step(float deltaTime);
+    void takeSnapshot();
+    void restoreSnapshot(const Snapshot& snapshot);
+    void clearSnapshots();
+    Snapshot& getSnapshot(u32 index) { return m_snapshots[(m_snapshotStart + index) % MAX_SNAPSHOTS]; }
+
+    // Moves the emitters in m_scheduleList that fit into this step's update budget to m_updateList
+    void scheduleUpdates();
+
+    // Hands out this step's spawn quotas to the emitters in m_updateList according to the budget policy.
+    // Returns true if no emitter can be denied a particle by another one, so they can update in any order.
+    bool distributeBudget();
+
+private:
+    // Particle storage, handed out to emitters in blocks. Must outlive the emitters.
+    ParticlePool m_pool;
+
+    SlotMap<SPLEmitter> m_emitters;
+    std::vector<EmitterHandle> m_awake; // Emitters considered for updates every step, in the order they are updated
+    SlotMap<EmitterSpawner> m_spawners;
+    TimerWheel<Timer> m_timers;
+    bool m_cycle = false;
+
+    bool m_fixedTimestep = false;
+    f32 m_accumulator = 0.0f; // Simulation time owed but not yet stepped
+    f32 m_interpolation = 1.0f;
+    u64 m_step = 0; // Number of simulation steps taken
+    f64 m_time = 0.0;
+
+    ThreadPool* m_threadPool = nullptr;
+    std::vector<SPLEmitter*> m_updateList; // Emitters due for an update this frame, reused to avoid allocations
+    std::vector<u32> m_spawnRequests; // Spawn upper bound of every emitter in m_updateList
+    std::vector<SPLEmitter*> m_scheduleList; // Emitters that may be deferred by the update budget
+
+    f32 m_updateBudget = 0.0f;
+    f64 m_updateCost = 0.0; // Measured seconds per particle update, averaged over recent steps
+    u64 m_scheduledCost = 0; // Particles scheduled for update in the current step
+
+    std::vector<PrewarmJob> m_prewarmJobs;
+    std::atomic<bool> m_cancelPrewarm = false;
+
+    BudgetPolicy m_budgetPolicy = BudgetPolicy::FirstCome;
+    std::atomic<u64> m_deniedSpawns = 0;
+
+    std::vector<Snapshot> m_snapshots; // Ring buffer ordered by step, the oldest one is at m_snapshotStart
+    u32 m_snapshotStart = 0;
+    u32 m_snapshotCount = 0;
+    u32 m_snapshotInterval = 0;
+    u64 m_historyEnd = 0; // Furthest step that was simulated since the history was last truncated
+
+    u64 m_seed = 0x243F6A8885A308D3ull;
+    u64 m_streamCount = 0;
+
+    u32 m_maxParticles;
+    std::atomic<u32> m_particleCount = 0;
+};
@@ -5,140 +5,156 @@
 #include <glm/common.hpp>
 
 
+namespace {
 
-void SPLScaleAnim::apply(SPLParticle& ptcl, const SPLResource& resource, f32 lifeRate) const {
+// Life rate represented by a table entry
+constexpr f32 tableLifeRate(u32 entry) {
+    return (f32)entry / (f32)(SPLAnim::TABLE_SIZE - 1);
+}
+
+}
+
+void SPLScaleAnim::apply(SPLParticleBlock& block, u32 index, u8 lifeRate) const {
+    block.animScale[index] = table[lifeRate];
+}
+
+void SPLScaleAnim::plot(std::span<f32> xs, std::span<f32> ys) const {
+    const size_t samples = std::min(xs.size(), ys.size());
+    for (size_t i = 0; i < samples; i++) {
+        const f32 lifeRate = (f32)i / (f32)samples;
+        xs[i] = lifeRate;
+        ys[i] = evaluate(lifeRate);
+    }
+}
+
+f32 SPLScaleAnim::evaluate(f32 lifeRate) const {
     const f32 in = curve.getIn();
     const f32 out = curve.getOut();
 
     if (lifeRate < in) {
-        ptcl.animScale = glm::mix(start, mid, lifeRate / in);
+        return glm::mix(start, mid, lifeRate / in);
     } else if (lifeRate < out) {
-        ptcl.animScale = mid;
+        return mid;
     } else {
-        ptcl.animScale = glm::mix(mid, end, (lifeRate - out) / (1.0f - out));
+        return glm::mix(mid, end, (lifeRate - out) / (1.0f - out));
     }
 }
 
-void SPLScaleAnim::plot(std::span<f32> xs, std::span<f32> ys) const {
+void SPLScaleAnim::bake() {
+    for (u32 i = 0; i < TABLE_SIZE; i++) {
+        table[i] = evaluate(tableLifeRate(i));
+    }
+}
+
+void SPLColorAnim::apply(SPLParticleBlock& block, u32 index, u8 lifeRate) const {
+    block.color[index] = table[lifeRate];
+}
+
+void SPLColorAnim::plot(const SPLResource& resource, std::span<f32> xs, std::span<glm::vec3> ys) const {
     const size_t samples = std::min(xs.size(), ys.size());
     for (size_t i = 0; i < samples; i++) {
         const f32 lifeRate = (f32)i / (f32)samples;
         xs[i] = lifeRate;
-
-        if (lifeRate < curve.getIn()) {
-            ys[i] = glm::mix(start, mid, lifeRate / curve.getIn());
-        } else if (lifeRate < curve.getOut()) {
-            ys[i] = mid;
-        } else {
-            ys[i] = glm::mix(mid, end, (lifeRate - curve.getOut()) / (1.0f - curve.getOut()));
-        }
+        ys[i] = evaluate(resource.header.color, lifeRate);
     }
 }
 
-void SPLColorAnim::apply(SPLParticle& ptcl, const SPLResource& resource, f32 lifeRate) const {
+glm::vec3 SPLColorAnim::evaluate(const glm::vec3& peakColor, f32 lifeRate) const {
     const float in = curve.getIn();
     const float peak = curve.getPeak();
     const float out = curve.getOut();
 
     if (lifeRate < in) {
-        ptcl.color = start;
+        return start;
     } else if (lifeRate < peak) {
         if (flags.interpolate) {
-            ptcl.color = glm::mix(start, resource.header.color, (lifeRate - in) / (peak - in));
+            return glm::mix(start, peakColor, (lifeRate - in) / (peak - in));
         } else {
-            ptcl.color = resource.header.color;
+            return peakColor;
         }
     } else if (lifeRate < out) {
         if (flags.interpolate) {
-            ptcl.color = glm::mix(resource.header.color, end, (lifeRate - peak) / (out - peak));
+            return glm::mix(peakColor, end, (lifeRate - peak) / (out - peak));
         } else {
-            ptcl.color = end;
+            return end;
         }
     } else {
-        ptcl.color = end;
+        return end;
     }
 }
 
-void SPLColorAnim::plot(const SPLResource& resource, std::span<f32> xs, std::span<glm::vec3> ys) const {
-    const float in = curve.getIn();
-    const float peak = curve.getPeak();
-    const float out = curve.getOut();
+void SPLColorAnim::bake(const glm::vec3& peakColor) {
+    for (u32 i = 0; i < TABLE_SIZE; i++) {
+        table[i] = evaluate(peakColor, tableLifeRate(i));
+    }
+}
 
+void SPLAlphaAnim::apply(SPLParticleBlock& block, u32 index, u8 lifeRate) const {
+    // Clamped after the random range, curves leaving [0, 1] still affect particles near the ends of the range
+    if (flags.randomRange > 0.0f) {
+        block.animAlpha[index] = glm::clamp(SPLRandom::scaledRange(table[lifeRate], flags.randomRange), 0.0f, 1.0f);
+    } else {
+        block.animAlpha[index] = glm::clamp(table[lifeRate], 0.0f, 1.0f);
+    }
+}
+
+void SPLAlphaAnim::plot(std::span<f32> xs, std::span<f32> ys) const {
     const size_t samples = std::min(xs.size(), ys.size());
     for (size_t i = 0; i < samples; i++) {
         const f32 lifeRate = (f32)i / (f32)samples;
         xs[i] = lifeRate;
-
-        if (lifeRate < in) {
-            ys[i] = start;
-        } else if (lifeRate < peak) {
-            if (flags.interpolate) {
-                ys[i] = glm::mix(start, resource.header.color, (lifeRate - in) / (peak - in));
-            } else {
-                ys[i] = resource.header.color;
-            }
-        } else if (lifeRate < out) {
-            if (flags.interpolate) {
-                ys[i] = glm::mix(resource.header.color, end, (lifeRate - peak) / (out - peak));
-            } else {
-                ys[i] = end;
-            }
-        } else {
-            ys[i] = end;
-        }
+        ys[i] = SPLRandom::scaledRange(evaluate(lifeRate), flags.randomRange);
     }
 }
 
-void SPLAlphaAnim::apply(SPLParticle& ptcl, const SPLResource& resource, f32 lifeRate) const {
+f32 SPLAlphaAnim::evaluate(f32 lifeRate) const {
     const f32 in = curve.getIn();
     const f32 out = curve.getOut();
 
     if (lifeRate < in) {
-        ptcl.visibility.animAlpha = glm::mix(alpha.start, alpha.mid, lifeRate / in);
+        return glm::mix(alpha.start, alpha.mid, lifeRate / in);
     } else if (lifeRate < out) {
-        ptcl.visibility.animAlpha = alpha.mid;
+        return alpha.mid;
     } else {
-        ptcl.visibility.animAlpha = glm::mix(alpha.mid, alpha.end, (lifeRate - out) / (1.0f - out));
+        return glm::mix(alpha.mid, alpha.end, (lifeRate - out) / (1.0f - out));
     }
-
-    ptcl.visibility.animAlpha = glm::clamp(
-        SPLRandom::scaledRange(ptcl.visibility.animAlpha, flags.randomRange), 
-        0.0f, 1.0f
-    );
 }
 
-void SPLAlphaAnim::plot(std::span<f32> xs, std::span<f32> ys) const {
-    const size_t samples = std::min(xs.size(), ys.size());
-    for (size_t i = 0; i < samples; i++) {
-        const f32 lifeRate = (f32)i / (f32)samples;
-        xs[i] = lifeRate;
-
-        if (lifeRate < curve.getIn()) {
-            ys[i] = glm::mix(alpha.start, alpha.mid, lifeRate / curve.getIn());
-        } else if (lifeRate < curve.getOut()) {
-            ys[i] = alpha.mid;
-        } else {
-            ys[i] = glm::mix(alpha.mid, alpha.end, (lifeRate - curve.getOut()) / (1.0f - curve.getOut()));
-        }
+void SPLAlphaAnim::bake() {
+    for (u32 i = 0; i < TABLE_SIZE; i++) {
+        table[i] = evaluate(tableLifeRate(i));
+    }
+}
 
-        ys[i] = SPLRandom::scaledRange(ys[i], flags.randomRange);
+void SPLTexAnim::apply(SPLParticleBlock& block, u32 index, u8 lifeRate) const {
+    if (param.textureCount > 0) {
+        block.texture[index] = table[lifeRate];
     }
 }
 
-void SPLTexAnim::apply(SPLParticle& ptcl, const SPLResource& resource, f32 lifeRate) const {
-    
-    for (int i = 0; i < param.textureCount; i++) {
-        if (lifeRate < param.step * (i + 1)) {
-            ptcl.texture = textures[i];
-            break;
+void SPLTexAnim::bake() {
+    if (param.textureCount == 0) {
+        return;
+    }
+
+    for (u32 i = 0; i < TABLE_SIZE; i++) {
+        const f32 lifeRate = tableLifeRate(i);
+
+        // Past the last frame the particle keeps showing it
+        table[i] = textures[param.textureCount - 1];
+        for (int frame = 0; frame < param.textureCount; frame++) {
+            if (lifeRate < param.step * (frame + 1)) {
+                table[i] = textures[frame];
+                break;
+            }
         }
     }
 }
 
-void SPLChildResource::applyScaleAnim(SPLParticle& ptcl, f32 lifeRate) const {
-    ptcl.animScale = glm::mix(0.0f, endScale, lifeRate); // scale up
+void SPLChildResource::applyScaleAnim(SPLParticleBlock& block, u32 index, f32 lifeRate) const {
+    block.animScale[index] = glm::mix(0.0f, endScale, lifeRate); // scale up
 }
 
-void SPLChildResource::applyAlphaAnim(SPLParticle& ptcl, f32 lifeRate) const {
-    ptcl.visibility.animAlpha = glm::mix(1.0f, 0.0f, lifeRate); // fade out
+void SPLChildResource::applyAlphaAnim(SPLParticleBlock& block, u32 index, f32 lifeRate) const {
+    block.animAlpha[index] = glm::mix(1.0f, 0.0f, lifeRate); // fade out
 }
@@ -1,7 +1,5 @@
 #include "spl_archive.h"
-#include "gfx/gl_util.h"
 
-#include <GL/glew.h>
 #include <glm/gtc/constants.hpp>
 #include <spdlog/spdlog.h>
 #include <stb_image_write.h>
@@ -90,8 +88,6 @@ SPLArchive::SPLArchive() {
     defaultTexture.textureData = std::span<const u8>(DEFAULT_TEXTURE.data(), DEFAULT_TEXTURE.size());
     defaultTexture.paletteData = std::span<const u8>((u8*)DEFAULT_PALETTE.data(), DEFAULT_PALETTE.size() * sizeof(GXRgba));
 
-    defaultTexture.glTexture = std::make_shared<GLTexture>(defaultTexture);
-
     m_textures.push_back(defaultTexture);
 }
 
@@ -187,6 +183,8 @@ void SPLArchive::load(const std::filesystem::path& filename) {
             file >> convergenceBehavior;
             res.behaviors.push_back(fromNative(convergenceBehavior));
         }
+
+        res.bakeAnimations();
     }
 
     m_textures.resize(m_header.texCount);
@@ -225,8 +223,6 @@ void SPLArchive::load(const std::filesystem::path& filename) {
 
             tex.textureData = m_textureData.back();
             tex.paletteData = m_paletteData.back();
-
-            tex.glTexture = std::make_shared<GLTexture>(tex);
         }
 
         file.seekg(offset + texRes.resourceSize, std::ios::beg);
@@ -237,7 +233,6 @@ void SPLArchive::load(const std::filesystem::path& filename) {
         if (tex.param.useSharedTexture) {
             tex.textureData = m_textureData[tex.param.sharedTexID];
             tex.paletteData = m_paletteData[tex.param.sharedTexID];
-            tex.glTexture = m_textures[tex.param.sharedTexID].glTexture;
         }
     }
 }
@@ -358,8 +353,8 @@ void SPLArchive::exportTextures(const std::filesystem::path& directory, const st
     }
 
     for (const auto [i, tex] : std::views::enumerate(m_textures)) {
-        if (!tex.glTexture) {
-            spdlog::warn("Texture {} does not have a GL texture, skipping export", i);
+        if (tex.textureData.empty()) {
+            spdlog::warn("Texture {} has no data, skipping export", i);
             continue;
         }
 
@@ -395,8 +390,8 @@ void SPLArchive::exportTexture(size_t index, const std::filesystem::path& file)
     }
 
     const auto& tex = m_textures[index];
-    if (!tex.glTexture) {
-        spdlog::warn("Texture {} does not have a GL texture, skipping export", index);
+    if (tex.textureData.empty()) {
+        spdlog::warn("Texture {} has no data, skipping export", index);
         return;
     }
 
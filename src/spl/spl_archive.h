@@ -19,6 +19,7 @@ enum {
 
 class SPLArchive {
 public:
+    // Loading never touches the GPU, GL textures are created separately (see GLTexture::createTextures)
     explicit SPLArchive(const std::filesystem::path& filename);
     SPLArchive();
 
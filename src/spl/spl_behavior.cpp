@@ -7,29 +7,60 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 
-void SPLGravityBehavior::apply(SPLParticle& particle, glm::vec3& acceleration, SPLEmitter& emitter, float dt) {
-    acceleration += magnitude;
+void SPLBehavior::apply(SPLParticleBlock& block, glm::vec3* acceleration, SPLEmitter& emitter, float dt) {
+    switch (type) {
+    case SPLBehaviorType::Gravity:
+        static_cast<SPLGravityBehavior*>(this)->applyBatch(block, acceleration, emitter, dt);
+        break;
+    case SPLBehaviorType::Random:
+        static_cast<SPLRandomBehavior*>(this)->applyBatch(block, acceleration, emitter, dt);
+        break;
+    case SPLBehaviorType::Magnet:
+        static_cast<SPLMagnetBehavior*>(this)->applyBatch(block, acceleration, emitter, dt);
+        break;
+    case SPLBehaviorType::Spin:
+        static_cast<SPLSpinBehavior*>(this)->applyBatch(block, acceleration, emitter, dt);
+        break;
+    case SPLBehaviorType::CollisionPlane:
+        static_cast<SPLCollisionPlaneBehavior*>(this)->applyBatch(block, acceleration, emitter, dt);
+        break;
+    case SPLBehaviorType::Convergence:
+        static_cast<SPLConvergenceBehavior*>(this)->applyBatch(block, acceleration, emitter, dt);
+        break;
+    }
+}
+
+// The batch loops below have no cross-iteration dependencies and work on plain streams,
+// so apart from the random behavior the compiler can vectorize them
+
+void SPLGravityBehavior::applyBatch(SPLParticleBlock& block, glm::vec3* acceleration, SPLEmitter& emitter, float dt) {
+    for (u32 i = 0; i < block.count; ++i) {
+        acceleration[i] += magnitude;
+    }
 }
 
 SPLRandomBehavior::SPLRandomBehavior(const SPLRandomBehaviorNative& native) : SPLBehavior(SPLBehaviorType::Random) {
     magnitude = native.magnitude.toVec3();
     applyInterval = (f32)native.applyInterval / SPLArchive::SPL_FRAMES_PER_SECOND;
-    lastApplication = std::chrono::steady_clock::now();
 }
 
-void SPLRandomBehavior::apply(SPLParticle& particle, glm::vec3& acceleration, SPLEmitter& emitter, float dt) {
-    const auto now = std::chrono::steady_clock::now();
-    const auto delta = std::chrono::duration_cast<std::chrono::duration<float>>(now - lastApplication);
-    if (delta.count() >= applyInterval) {
-        acceleration.x += SPLRandom::aroundZero(magnitude.x);
-        acceleration.y += SPLRandom::aroundZero(magnitude.y);
-        acceleration.z += SPLRandom::aroundZero(magnitude.z);
-        lastApplication = now;
+void SPLRandomBehavior::applyBatch(SPLParticleBlock& block, glm::vec3* acceleration, SPLEmitter& emitter, float dt) {
+    if (!emitter.shouldApplyRandomBehavior()) {
+        return;
+    }
+
+    f32 values[SPLParticleBlock::CAPACITY * 3];
+    SPLRandom::fillN({ values, block.count * 3 });
+
+    for (u32 i = 0; i < block.count; ++i) {
+        acceleration[i] += glm::vec3(values[i * 3], values[i * 3 + 1], values[i * 3 + 2]) * magnitude;
     }
 }
 
-void SPLMagnetBehavior::apply(SPLParticle& particle, glm::vec3& acceleration, SPLEmitter& emitter, float dt) {
-    acceleration += force * (target - (particle.position + particle.velocity));
+void SPLMagnetBehavior::applyBatch(SPLParticleBlock& block, glm::vec3* acceleration, SPLEmitter& emitter, float dt) {
+    for (u32 i = 0; i < block.count; ++i) {
+        acceleration[i] += force * (target - (block.position[i] + block.velocity[i]));
+    }
 }
 
 SPLSpinBehavior::SPLSpinBehavior(const SPLSpinBehaviorNative& native) : SPLBehavior(SPLBehaviorType::Spin) {
@@ -37,47 +68,62 @@ SPLSpinBehavior::SPLSpinBehavior(const SPLSpinBehaviorNative& native) : SPLBehav
     angle = static_cast<f32>(native.angle) / 65535.0f * glm::two_pi<f32>();
 }
 
-void SPLSpinBehavior::apply(SPLParticle& particle, glm::vec3& acceleration, SPLEmitter& emitter, float dt) {
+void SPLSpinBehavior::applyBatch(SPLParticleBlock& block, glm::vec3* acceleration, SPLEmitter& emitter, float dt) {
+    glm::vec3 rotationAxis{};
     switch (axis) {
     case SPLSpinAxis::X:
-        particle.position = glm::rotate(glm::mat4(1), angle * dt, { 1, 0, 0 }) * glm::vec4(particle.position, 1);
+        rotationAxis = { 1, 0, 0 };
         break;
     case SPLSpinAxis::Y:
-        particle.position = glm::rotate(glm::mat4(1), angle * dt, { 0, 1, 0 }) * glm::vec4(particle.position, 1);
+        rotationAxis = { 0, 1, 0 };
         break;
     case SPLSpinAxis::Z:
-        particle.position = glm::rotate(glm::mat4(1), angle * dt, { 0, 0, 1 }) * glm::vec4(particle.position, 1);
+        rotationAxis = { 0, 0, 1 };
         break;
+    default:
+        return;
+    }
+
+    const glm::mat4 rotation = glm::rotate(glm::mat4(1), angle * dt, rotationAxis);
+    for (u32 i = 0; i < block.count; ++i) {
+        block.position[i] = rotation * glm::vec4(block.position[i], 1);
     }
 }
 
-void SPLCollisionPlaneBehavior::apply(SPLParticle& particle, glm::vec3& acceleration, SPLEmitter& emitter, float dt) {
+void SPLCollisionPlaneBehavior::applyBatch(SPLParticleBlock& block, glm::vec3* acceleration, SPLEmitter& emitter, float dt) {
     const f32 cy = emitter.m_collisionPlaneHeight > std::numeric_limits<f32>::min()
         ? emitter.m_collisionPlaneHeight
         : this->y;
 
-    constexpr auto moved_above = [](f32 py_, f32 ey_, f32 cy_) { return ey_ < cy_ && ey_ + py_ > cy_; };
-    constexpr auto moved_below = [](f32 py_, f32 ey_, f32 cy_) { return ey_ >= cy_ && ey_ + py_ < cy_; };
-
-    const f32 py = particle.position.y;
-    const f32 ey = particle.emitterPos.y;
+    // Written as selects rather than branches so both loops vectorize
+    const auto crossed = [cy](f32 py, f32 ey) {
+        const bool movedAbove = ey < cy && ey + py > cy;
+        const bool movedBelow = ey >= cy && ey + py < cy;
+        return movedAbove || movedBelow;
+    };
 
     switch (collisionType) {
     case SPLCollisionType::Kill:
-        if (moved_above(py, ey, cy) || moved_below(py, ey, cy)) {
-            particle.position.y = cy - ey;
-            particle.age = particle.lifeTime;
+        for (u32 i = 0; i < block.count; ++i) {
+            const f32 ey = block.emitterPos[i].y;
+            const bool hit = crossed(block.position[i].y, ey);
+            block.position[i].y = hit ? cy - ey : block.position[i].y;
+            block.age[i] = hit ? block.lifeTime[i] : block.age[i];
         }
         break;
     case SPLCollisionType::Bounce:
-        if (moved_above(py, ey, cy) || moved_below(py, ey, cy)) {
-            particle.position.y = cy - ey;
-            particle.velocity.y *= -elasticity;
+        for (u32 i = 0; i < block.count; ++i) {
+            const f32 ey = block.emitterPos[i].y;
+            const bool hit = crossed(block.position[i].y, ey);
+            block.position[i].y = hit ? cy - ey : block.position[i].y;
+            block.velocity[i].y = hit ? block.velocity[i].y * -elasticity : block.velocity[i].y;
         }
         break;
     }
 }
 
-void SPLConvergenceBehavior::apply(SPLParticle& particle, glm::vec3& acceleration, SPLEmitter& emitter, float dt) {
-    particle.position += force * (target - particle.position) * dt;
+void SPLConvergenceBehavior::applyBatch(SPLParticleBlock& block, glm::vec3* acceleration, SPLEmitter& emitter, float dt) {
+    for (u32 i = 0; i < block.count; ++i) {
+        block.position[i] += force * (target - block.position[i]) * dt;
+    }
 }
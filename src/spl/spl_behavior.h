@@ -2,13 +2,12 @@
 #include "types.h"
 #include "fx.h"
 
-#include <chrono>
 #include <functional>
 #include <glm/glm.hpp>
 #include <spdlog/spdlog.h>
 
 
-class SPLParticle;
+struct SPLParticleBlock;
 class SPLEmitter;
 
 enum class SPLSpinAxis {
@@ -35,7 +34,11 @@ struct SPLBehavior {
     SPLBehaviorType type;
 
     explicit SPLBehavior(SPLBehaviorType type) : type(type) {}
-    virtual void apply(SPLParticle& particle, glm::vec3& acceleration, SPLEmitter& emitter, float dt) = 0;
+    virtual ~SPLBehavior() = default;
+
+    // Applies the behavior to every particle of a block, `acceleration` holds one value per particle.
+    // Dispatches on the type once per block, the per-particle loops live in the concrete behaviors' applyBatch.
+    void apply(SPLParticleBlock& block, glm::vec3* acceleration, SPLEmitter& emitter, float dt);
 };
 
 // Applies a gravity behavior to particles
@@ -94,23 +97,21 @@ struct SPLGravityBehavior : SPLBehavior {
         : SPLBehavior(SPLBehaviorType::Gravity)
         , magnitude(mag) {}
 
-    void apply(SPLParticle& particle, glm::vec3& acceleration, SPLEmitter& emitter, float dt) override;
+    void applyBatch(SPLParticleBlock& block, glm::vec3* acceleration, SPLEmitter& emitter, float dt);
 };
 
 struct SPLRandomBehavior : SPLBehavior {
     glm::vec3 magnitude;
-    f32 applyInterval;
-    std::chrono::time_point<std::chrono::steady_clock> lastApplication;
+    f32 applyInterval; // simulation time between applications, in seconds
 
     explicit SPLRandomBehavior(const SPLRandomBehaviorNative& native);
 
     SPLRandomBehavior(const glm::vec3& mag, f32 interval)
         : SPLBehavior(SPLBehaviorType::Random)
         , magnitude(mag)
-        , applyInterval(interval)
-        , lastApplication(std::chrono::steady_clock::now()) {}
+        , applyInterval(interval) {}
 
-    void apply(SPLParticle& particle, glm::vec3& acceleration, SPLEmitter& emitter, float dt) override;
+    void applyBatch(SPLParticleBlock& block, glm::vec3* acceleration, SPLEmitter& emitter, float dt);
 };
 
 struct SPLMagnetBehavior : SPLBehavior {
@@ -127,7 +128,7 @@ struct SPLMagnetBehavior : SPLBehavior {
         , target(target)
         , force(force) {}
 
-    void apply(SPLParticle& particle, glm::vec3& acceleration, SPLEmitter& emitter, float dt) override;
+    void applyBatch(SPLParticleBlock& block, glm::vec3* acceleration, SPLEmitter& emitter, float dt);
 };
 
 struct SPLSpinBehavior : SPLBehavior {
@@ -141,7 +142,7 @@ struct SPLSpinBehavior : SPLBehavior {
         , angle(angle)
         , axis(axis) {}
 
-    void apply(SPLParticle& particle, glm::vec3& acceleration, SPLEmitter& emitter, float dt) override;
+    void applyBatch(SPLParticleBlock& block, glm::vec3* acceleration, SPLEmitter& emitter, float dt);
 };
 
 struct SPLCollisionPlaneBehavior : SPLBehavior {
@@ -161,7 +162,7 @@ struct SPLCollisionPlaneBehavior : SPLBehavior {
         , elasticity(elasticity)
         , collisionType(type) {}
 
-    void apply(SPLParticle& particle, glm::vec3& acceleration, SPLEmitter& emitter, float dt) override;
+    void applyBatch(SPLParticleBlock& block, glm::vec3* acceleration, SPLEmitter& emitter, float dt);
 };
 
 struct SPLConvergenceBehavior : SPLBehavior {
@@ -178,7 +179,7 @@ struct SPLConvergenceBehavior : SPLBehavior {
         , target(target)
         , force(force) {}
 
-    void apply(SPLParticle& particle, glm::vec3& acceleration, SPLEmitter& emitter, float dt) override;
+    void applyBatch(SPLParticleBlock& block, glm::vec3* acceleration, SPLEmitter& emitter, float dt);
 };
 
 
@@ -1,17 +1,42 @@
 #include "spl_emitter.h"
-#include "editor/particle_system.h"
-#include "editor/camera.h"
+#include "particle_system.h"
 #include "spl_random.h"
+#include "spl_integrate.h"
+#include "spl_shape.h"
+#include "util/thread_pool.h"
 
-#include <glm/gtc/random.hpp>
 #include <glm/gtc/constants.hpp>
-#include <ranges>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <utility>
 
 
-SPLEmitter::SPLEmitter(const SPLResource* resource, ParticleSystem* system, bool looping, const glm::vec3& pos) {
+namespace {
+
+// Emitter updates per kernel specialization, see SPLEmitter::getParticleKernelUsage
+std::array<std::atomic<u64>, SPLEmitter::PARTICLE_KERNEL_COUNT> g_particleKernelUsage = {};
+std::array<std::atomic<u64>, SPLEmitter::CHILD_KERNEL_COUNT> g_childKernelUsage = {};
+
+// Most emissions a timer can trigger: update subtracts the interval while the timer is at least the interval,
+// which float rounding can make run once more than the quotient says
+f64 getMaxEmissions(f32 timer, f32 interval) {
+    return interval > 0.0f ? std::floor(std::max(timer, 0.0f) / (f64)interval) + 1.0 : 1.0;
+}
+
+u32 saturate(f64 count) {
+    return count < (f64)std::numeric_limits<u32>::max() ? (u32)count : std::numeric_limits<u32>::max();
+}
+
+}
+
+SPLEmitter::SPLEmitter(const SPLResource* resource, ParticleSystem* system, bool looping, const glm::vec3& pos)
+    : m_particles(system), m_childParticles(system), m_random(system->createRandomStream()) {
     m_resource = resource;
     m_system = system;
     m_state = { .looping = looping };
+    m_lastRandomApplication = system->getTime();
 
     m_position = pos + resource->header.emitterBasePos;
     m_particleInitVelocity = {};
@@ -70,170 +95,361 @@ SPLEmitter::SPLEmitter(const SPLResource* resource, ParticleSystem* system, bool
 }
 
 SPLEmitter::~SPLEmitter() {
-    for (const auto ptcl : m_particles) {
-        m_system->freeParticle(ptcl);
-    }
-
-    for (const auto ptcl : m_childParticles) {
-        m_system->freeParticle(ptcl);
-    }
-
     m_particles.clear();
     m_childParticles.clear();
 }
 
-void SPLEmitter::update(float deltaTime) {
+SPLEmitter::SPLEmitter(const SPLEmitter& other)
+    : m_resource(other.m_resource)
+    , m_system(other.m_system)
+    , m_particles(other.m_system)
+    , m_childParticles(other.m_system)
+    , m_state(other.m_state)
+    , m_random(other.m_random)
+    , m_position(other.m_position)
+    , m_velocity(other.m_velocity)
+    , m_particleInitVelocity(other.m_particleInitVelocity)
+    , m_age(other.m_age)
+    , m_emissionTimer(other.m_emissionTimer)
+    , m_lastRandomApplication(other.m_lastRandomApplication)
+    , m_applyRandomBehavior(other.m_applyRandomBehavior)
+    , m_maxParentEmissionTimer(other.m_maxParentEmissionTimer)
+    , m_axis(other.m_axis)
+    , m_initAngle(other.m_initAngle)
+    , m_emissionCount(other.m_emissionCount)
+    , m_radius(other.m_radius)
+    , m_length(other.m_length)
+    , m_initVelPositionAmplifier(other.m_initVelPositionAmplifier)
+    , m_initVelAxisAmplifier(other.m_initVelAxisAmplifier)
+    , m_baseScale(other.m_baseScale)
+    , m_particleLifeTime(other.m_particleLifeTime)
+    , m_color(other.m_color)
+    , m_collisionPlaneHeight(other.m_collisionPlaneHeight)
+    , m_texCoords(other.m_texCoords)
+    , m_childTexCoords(other.m_childTexCoords)
+    , m_emissionInterval(other.m_emissionInterval)
+    , m_baseAlpha(other.m_baseAlpha)
+    , m_updateCycle(other.m_updateCycle)
+    , m_lastStep(other.m_lastStep)
+    , m_pendingTime(other.m_pendingTime)
+    , m_visible(other.m_visible)
+    , m_sleeping(other.m_sleeping)
+    , m_sleepStart(other.m_sleepStart)
+    , m_bounds(other.m_bounds)
+    , m_priority(other.m_priority)
+    , m_spawnQuota(other.m_spawnQuota)
+    , m_deniedSpawns(other.m_deniedSpawns)
+    , m_crossAxis1(other.m_crossAxis1)
+    , m_crossAxis2(other.m_crossAxis2) {
+}
+
+template<u32 Features>
+void SPLEmitter::updateParticles(const KernelArgs& args, std::span<SPLParticleBlock* const> blocks, u32 chunk) {
+    constexpr bool hasAnims = (Features & (KernelScaleAnim | KernelColorAnim | KernelAlphaAnim | KernelTexAnim)) != 0;
     const auto& header = m_resource->header;
-    constexpr auto wrap_f32 = [](f32 x) { return x - std::floor(x); };
 
-    if (!m_state.terminate) {
-        if (header.misc.emissionInterval == 0.0f || m_age == 0.0f) { // Special handling for the first frame, where lifeTime == emissionInterval
-            emit((u32)header.emissionCount);
-        } else {
-            if (m_age <= header.emitterLifeTime) {
-                while (m_emissionTimer >= header.misc.emissionInterval) {
-                    emit((u32)header.emissionCount);
-                    m_emissionTimer -= header.misc.emissionInterval;
+    auto& childSpawns = m_childSpawns[chunk];
+    childSpawns.clear();
+
+    f32 maxEmissionTimer = 0.0f;
+    u32 firstDead = NO_DEAD;
+
+    alignas(32) glm::vec3 acceleration[SPLParticleBlock::CAPACITY];
+
+    u32 particle = m_particles.getBlockStart(chunk * CHUNK_BLOCKS);
+    for (const auto block : blocks) {
+        for (u32 i = 0; i < block->count; ++i) {
+            block->beginStep(i);
+
+            if constexpr (hasAnims) {
+                const u8 lifeRates[2] = {
+                    block->getLifeRate(i), // non-looping
+                    block->getLoopRate(i, args.loopTimeFactor) // looping
+                };
+
+                if constexpr ((Features & KernelScaleAnim) != 0) {
+                    args.scaleAnim->apply(*block, i, lifeRates[args.scaleLoop]);
+                }
+
+                if constexpr ((Features & KernelColorAnim) != 0) {
+                    args.colorAnim->apply(*block, i, lifeRates[args.colorLoop]);
+                }
+
+                if constexpr ((Features & KernelAlphaAnim) != 0) {
+                    args.alphaAnim->apply(*block, i, lifeRates[args.alphaLoop]);
+                }
+
+                if constexpr ((Features & KernelTexAnim) != 0) {
+                    args.texAnim->apply(*block, i, lifeRates[args.texLoop]);
                 }
             }
+
+            if constexpr ((Features & KernelFollowEmitter) != 0) {
+                block->emitterPos[i] = m_position;
+            }
+
+            acceleration[i] = {};
         }
-    }
 
-    struct AnimFunc {
-        const SPLAnim* anim;
-        bool loop;
+        for (const auto& behavior : m_resource->behaviors) {
+            behavior->apply(*block, acceleration, *this, args.deltaTime);
+        }
+
+        // Only depends on age and emission timer, which are advanced by the integrator below
+        if constexpr ((Features & KernelChildren) != 0) {
+            const auto& child = *args.child;
+
+            for (u32 i = 0; i < block->count; ++i) {
+                const auto lifeRate = block->age[i] / block->lifeTime[i];
+
+                u32 emissions = 0;
+                if (lifeRate >= child.misc.emissionDelay) {
+                    if (child.misc.emissionInterval == 0.0f || block->age[i] == 0.0f) {
+                        emissions = 1;
+                    } else {
+                        while (block->emissionTimer[i] >= child.misc.emissionInterval) {
+                            ++emissions;
+                            block->emissionTimer[i] -= child.misc.emissionInterval;
+                        }
+                    }
+                }
 
-        void operator()(SPLParticle& ptcl, const SPLResource& resource, f32 lifeRate) const {
-            anim->apply(ptcl, resource, lifeRate);
+                if (emissions > 0) {
+                    childSpawns.push_back({ particle + i, emissions * child.misc.emissionCount });
+                }
+            }
         }
-    };
 
-    AnimFunc animFuncs[4] = {};
-    int animFuncCount = 0;
+        SPLIntegrator::integrate(*block, acceleration, header.misc.airResistance, m_velocity, args.deltaTime);
 
-    if (header.flags.hasScaleAnim && m_resource->scaleAnim) {
-        animFuncs[animFuncCount++] = AnimFunc{
-            &m_resource->scaleAnim.value(),
-            m_resource->scaleAnim->flags.loop
-        };
-    }
+        // Lets the particle system bound the next update's child spawns without visiting every parent
+        if constexpr ((Features & KernelChildren) != 0) {
+            for (u32 i = 0; i < block->count; ++i) {
+                maxEmissionTimer = std::max(maxEmissionTimer, block->emissionTimer[i]);
+            }
+        }
 
-    if (header.flags.hasColorAnim && m_resource->colorAnim && !m_resource->colorAnim->flags.randomStartColor) {
-        animFuncs[animFuncCount++] = {
-            &m_resource->colorAnim.value(),
-            m_resource->colorAnim->flags.loop
-        };
-    }
+        if (firstDead == NO_DEAD) {
+            firstDead = findFirstDead(*block, particle);
+        }
 
-    if (header.flags.hasAlphaAnim && m_resource->alphaAnim) {
-        animFuncs[animFuncCount++] = {
-            &m_resource->alphaAnim.value(),
-            m_resource->alphaAnim->flags.loop
-        };
+        particle += block->count;
     }
 
-    if (header.flags.hasTexAnim && m_resource->texAnim && !m_resource->texAnim->param.randomizeInit) {
-        animFuncs[animFuncCount++] = {
-            &m_resource->texAnim.value(),
-            m_resource->texAnim->param.loop
-        };
-    }
+    m_chunkEmissionTimers[chunk] = maxEmissionTimer;
+    m_chunkFirstDead[chunk] = firstDead;
+}
+
+template<u32 Features>
+void SPLEmitter::updateChildParticles(const KernelArgs& args, std::span<SPLParticleBlock* const> blocks, u32 chunk) {
+    const auto& header = m_resource->header;
+    const auto& child = *args.child;
 
-    std::vector<SPLParticle*> particlesToRemove;
-    std::vector<SPLParticle*> childParticlesToRemove;
+    u32 firstDead = NO_DEAD;
 
-    for (const auto ptcl : m_particles) {
-        const f32 lifeRates[2] = {
-            ptcl->age / ptcl->lifeTime, // non-looping
-            wrap_f32(ptcl->lifeRateOffset + ptcl->age / m_resource->header.misc.loopTime) // looping
-        };
+    alignas(32) glm::vec3 acceleration[SPLParticleBlock::CAPACITY];
+
+    u32 particle = m_childParticles.getBlockStart(chunk * CHUNK_BLOCKS);
+    for (const auto block : blocks) {
+        for (u32 i = 0; i < block->count; ++i) {
+            block->beginStep(i);
+
+            if constexpr ((Features & (ChildKernelScaleAnim | ChildKernelAlphaAnim)) != 0) {
+                const f32 lifeRate = block->age[i] / block->lifeTime[i];
+
+                if constexpr ((Features & ChildKernelScaleAnim) != 0) {
+                    child.applyScaleAnim(*block, i, lifeRate);
+                }
 
-        for (int i = 0; i < animFuncCount; ++i) {
-            animFuncs[i](*ptcl, *m_resource, lifeRates[animFuncs[i].loop]);
+                if constexpr ((Features & ChildKernelAlphaAnim) != 0) {
+                    child.applyAlphaAnim(*block, i, lifeRate);
+                }
+            }
+
+            if constexpr ((Features & ChildKernelFollowEmitter) != 0) {
+                block->emitterPos[i] = m_position;
+            }
+
+            acceleration[i] = {};
         }
 
-        if (header.flags.followEmitter) {
-            ptcl->emitterPos = m_position;
+        if (child.flags.usesBehaviors) {
+            for (const auto& behavior : m_resource->behaviors) {
+                behavior->apply(*block, acceleration, *this, args.deltaTime);
+            }
         }
 
-        glm::vec3 acc{};
+        SPLIntegrator::integrate(*block, acceleration, header.misc.airResistance, m_velocity, args.deltaTime);
 
-        for (const auto& behavior : m_resource->behaviors) {
-            behavior->apply(*ptcl, acc, *this, deltaTime);
+        if (firstDead == NO_DEAD) {
+            firstDead = findFirstDead(*block, particle);
         }
 
-        ptcl->rotation += ptcl->angularVelocity * deltaTime;
+        particle += block->count;
+    }
 
-        ptcl->velocity *= header.misc.airResistance;
-        ptcl->velocity += acc * deltaTime;
+    m_chunkFirstDead[chunk] = firstDead;
+}
 
-        ptcl->position += (ptcl->velocity + m_velocity) * deltaTime;
+u32 SPLEmitter::getKernelFeatures() const {
+    const auto& header = m_resource->header;
 
-        if (header.flags.hasChildResource && m_resource->childResource) {
-            const auto& child = m_resource->childResource.value();
-            const auto lifeRate = ptcl->age / ptcl->lifeTime;
+    u32 features = 0;
+    if (header.flags.hasScaleAnim && m_resource->scaleAnim) {
+        features |= KernelScaleAnim;
+    }
 
-            if (lifeRate >= child.misc.emissionDelay) {
-                if (child.misc.emissionInterval == 0.0f || ptcl->age == 0.0f) {
-                    emitChildren(*ptcl, child.misc.emissionCount);
-                } else {
-                    while (ptcl->emissionTimer >= child.misc.emissionInterval) {
-                        emitChildren(*ptcl, child.misc.emissionCount);
-                        ptcl->emissionTimer -= child.misc.emissionInterval;
-                    }
-                }
-            }
-        }
+    // Random start colors and textures are picked at emission and never animated
+    if (header.flags.hasColorAnim && m_resource->colorAnim && !m_resource->colorAnim->flags.randomStartColor) {
+        features |= KernelColorAnim;
+    }
 
-        ptcl->age += deltaTime;
-        ptcl->emissionTimer += deltaTime;
+    if (header.flags.hasAlphaAnim && m_resource->alphaAnim) {
+        features |= KernelAlphaAnim;
+    }
 
-        if (ptcl->age >= ptcl->lifeTime) {
-            particlesToRemove.push_back(ptcl);
-        }
+    if (header.flags.hasTexAnim && m_resource->texAnim && !m_resource->texAnim->param.randomizeInit) {
+        features |= KernelTexAnim;
+    }
+
+    if (header.flags.followEmitter) {
+        features |= KernelFollowEmitter;
     }
 
     if (header.flags.hasChildResource && m_resource->childResource) {
-        auto& child = m_resource->childResource.value();
+        features |= KernelChildren;
+    }
 
-        for (const auto ptcl : m_childParticles) {
-            const f32 lifeRate = ptcl->age / ptcl->lifeTime;
-            if (child.flags.hasScaleAnim) {
-                child.applyScaleAnim(*ptcl, lifeRate);
-            }
+    return features;
+}
 
-            if (child.flags.hasAlphaAnim) {
-                child.applyAlphaAnim(*ptcl, lifeRate);
-            }
+u32 SPLEmitter::getChildKernelFeatures() const {
+    if (!m_resource->childResource) {
+        return 0;
+    }
 
-            if (child.flags.followEmitter) {
-                ptcl->emitterPos = m_position;
-            }
+    const auto& flags = m_resource->childResource->flags;
 
-            glm::vec3 acc{};
+    u32 features = 0;
+    if (flags.hasScaleAnim) {
+        features |= ChildKernelScaleAnim;
+    }
 
-            if (child.flags.usesBehaviors) {
-                for (const auto& behavior : m_resource->behaviors) {
-                    behavior->apply(*ptcl, acc, *this, deltaTime);
-                }
-            }
+    if (flags.hasAlphaAnim) {
+        features |= ChildKernelAlphaAnim;
+    }
 
-            ptcl->rotation += ptcl->angularVelocity * deltaTime;
+    if (flags.followEmitter) {
+        features |= ChildKernelFollowEmitter;
+    }
 
-            ptcl->velocity *= header.misc.airResistance;
-            ptcl->velocity += acc * deltaTime;
+    return features;
+}
+
+u64 SPLEmitter::getParticleKernelUsage(u32 features) {
+    return features < PARTICLE_KERNEL_COUNT ? g_particleKernelUsage[features].load(std::memory_order_relaxed) : 0;
+}
 
-            ptcl->position += (ptcl->velocity + m_velocity) * deltaTime;
+u64 SPLEmitter::getChildKernelUsage(u32 features) {
+    return features < CHILD_KERNEL_COUNT ? g_childKernelUsage[features].load(std::memory_order_relaxed) : 0;
+}
+
+void SPLEmitter::update(float deltaTime) {
+    const SPLRandom::Scope random(m_random);
+    const auto& header = m_resource->header;
 
-            ptcl->age += deltaTime;
-            ptcl->emissionTimer += deltaTime;
+    updateBehaviorTimers();
 
-            if (ptcl->age >= ptcl->lifeTime) {
-                childParticlesToRemove.push_back(ptcl);
+    if (!m_state.terminate) {
+        if (header.misc.emissionInterval == 0.0f || m_age == 0.0f) { // Special handling for the first frame, where lifeTime == emissionInterval
+            emit((u32)header.emissionCount);
+        } else {
+            if (m_age <= header.emitterLifeTime) {
+                while (m_emissionTimer >= header.misc.emissionInterval) {
+                    emit((u32)header.emissionCount);
+                    m_emissionTimer -= header.misc.emissionInterval;
+                }
             }
         }
     }
 
+    const KernelArgs args = {
+        .scaleAnim = m_resource->scaleAnim ? &m_resource->scaleAnim.value() : nullptr,
+        .colorAnim = m_resource->colorAnim ? &m_resource->colorAnim.value() : nullptr,
+        .alphaAnim = m_resource->alphaAnim ? &m_resource->alphaAnim.value() : nullptr,
+        .texAnim = m_resource->texAnim ? &m_resource->texAnim.value() : nullptr,
+        .child = m_resource->childResource ? &m_resource->childResource.value() : nullptr,
+        .scaleLoop = (u8)(m_resource->scaleAnim && m_resource->scaleAnim->flags.loop),
+        .colorLoop = (u8)(m_resource->colorAnim && m_resource->colorAnim->flags.loop),
+        .alphaLoop = (u8)(m_resource->alphaAnim && m_resource->alphaAnim->flags.loop),
+        .texLoop = (u8)(m_resource->texAnim && m_resource->texAnim->param.loop),
+        .loopTimeFactor = SPLParticleBlock::computeRateFactor(header.misc.loopTime),
+        .deltaTime = deltaTime,
+    };
+
+    // One instantiation of each kernel per feature mask, the mask is looked up once per update
+    static constexpr auto particleKernels = []<u32... Features>(std::integer_sequence<u32, Features...>) {
+        return std::array{ &SPLEmitter::updateParticles<Features>... };
+    }(std::make_integer_sequence<u32, PARTICLE_KERNEL_COUNT>());
+
+    static constexpr auto childKernels = []<u32... Features>(std::integer_sequence<u32, Features...>) {
+        return std::array{ &SPLEmitter::updateChildParticles<Features>... };
+    }(std::make_integer_sequence<u32, CHILD_KERNEL_COUNT>());
+
+    const u32 features = getKernelFeatures();
+    const auto particleKernel = particleKernels[features];
+    g_particleKernelUsage[features].fetch_add(1, std::memory_order_relaxed);
+
+    // Particles are simulated in chunks, which run in parallel for large emitters.
+    // Child spawns and retiring dead particles touch the lists themselves, so they are
+    // deferred and merged afterwards in particle order to keep the result independent of scheduling.
+    const bool hasChildren = (features & KernelChildren) != 0;
+    const u32 chunkCount = std::max(getChunkCount(m_particles), 1u);
+    m_childSpawns.resize(chunkCount);
+    m_chunkEmissionTimers.resize(chunkCount);
+    m_chunkFirstDead.resize(chunkCount);
+
+    forEachChunk(m_particles, [&](std::span<SPLParticleBlock* const> blocks, u32 chunk) {
+        (this->*particleKernel)(args, blocks, chunk);
+    });
+
+    // Parents keep aging without a child resource, if one is added later their timers have to be looked at
+    if (hasChildren) {
+        m_maxParentEmissionTimer = *std::max_element(m_chunkEmissionTimers.begin(), m_chunkEmissionTimers.end());
+    } else {
+        m_maxParentEmissionTimer = m_particles.empty() ? 0.0f : -1.0f;
+    }
+
+    if (hasChildren) {
+        emitChildren();
+    }
+
+    // Collision planes can kill particles anywhere in the lists
+    bool killed = false;
+    for (const auto& behavior : m_resource->behaviors) {
+        if (behavior->type == SPLBehaviorType::CollisionPlane) {
+            const auto& collision = static_cast<const SPLCollisionPlaneBehavior&>(*behavior);
+            killed = killed || collision.collisionType == SPLCollisionType::Kill;
+        }
+    }
+
+    retireDeadParticles(m_particles, killed);
+
+    if (hasChildren) {
+        const u32 childFeatures = getChildKernelFeatures();
+        const auto childKernel = childKernels[childFeatures];
+        g_childKernelUsage[childFeatures].fetch_add(1, std::memory_order_relaxed);
+
+        m_chunkFirstDead.resize(std::max(getChunkCount(m_childParticles), 1u));
+        forEachChunk(m_childParticles, [&](std::span<SPLParticleBlock* const> blocks, u32 chunk) {
+            (this->*childKernel)(args, blocks, chunk);
+        });
+
+        retireDeadParticles(m_childParticles, killed && args.child->flags.usesBehaviors);
+    }
+
+    updateBounds();
+
     m_age += deltaTime;
     m_emissionTimer += deltaTime;
 
@@ -241,32 +457,102 @@ void SPLEmitter::update(float deltaTime) {
         m_age = 0;
         m_emissionTimer = 0;
     }
+}
+
+u32 SPLEmitter::getChunkCount(const SPLParticleList& list) {
+    return ((u32)list.getBlocks().size() + CHUNK_BLOCKS - 1) / CHUNK_BLOCKS;
+}
 
-    for (const auto ptcl : particlesToRemove) {
-        std::erase(m_particles, ptcl);
-        m_system->freeParticle(ptcl);
+template<typename Fn>
+void SPLEmitter::forEachChunk(const SPLParticleList& list, Fn&& fn) {
+    const auto blocks = list.getBlocks();
+    const u32 chunkCount = getChunkCount(list);
+    if (chunkCount <= 1) {
+        fn(blocks, 0);
+        return;
     }
 
-    for (const auto ptcl : childParticlesToRemove) {
-        std::erase(m_childParticles, ptcl);
-        m_system->freeParticle(ptcl);
+    // Every chunk draws from its own stream, derived from the emitter's,
+    // so the random numbers a particle gets don't depend on which thread runs it
+    const u64 seed = SPLRandom::nextU64();
+    const auto runChunk = [&](u32 chunk) {
+        SPLRandom::Generator generator(seed, chunk);
+        const SPLRandom::Scope random(generator);
+
+        const u32 first = chunk * CHUNK_BLOCKS;
+        fn(blocks.subspan(first, std::min<size_t>(CHUNK_BLOCKS, blocks.size() - first)), chunk);
+    };
+
+    const auto threadPool = m_system->getThreadPool();
+    if (threadPool) {
+        threadPool->parallelFor(chunkCount, 1, runChunk);
+    } else {
+        for (u32 chunk = 0; chunk < chunkCount; ++chunk) {
+            runChunk(chunk);
+        }
     }
 }
 
-void SPLEmitter::render(const CameraParams& params) {
-    auto& renderer = m_system->getRenderer();
-    for (const auto ptcl : std::views::reverse(m_particles)) {
-        ptcl->render(&renderer, params, m_texCoords.s, m_texCoords.t);
+u32 SPLEmitter::findFirstDead(const SPLParticleBlock& block, u32 blockStart) {
+    for (u32 i = 0; i < block.count; ++i) {
+        if (block.age[i] >= block.lifeTime[i]) {
+            return blockStart + i;
+        }
+    }
+
+    return NO_DEAD;
+}
+
+void SPLEmitter::retireDeadParticles(SPLParticleList& list, bool killed) {
+    const u32 firstDead = *std::min_element(m_chunkFirstDead.begin(), m_chunkFirstDead.end());
+    if (firstDead >= list.size()) {
+        return;
+    }
+
+    // Lists in expiry order only lose particles at the front, so only the expired ones have to be looked at
+    if (list.isExpiryOrdered() && !killed) {
+        u32 expired = 0;
+        for (const auto block : list.getBlocks()) {
+            u32 i = 0;
+            while (i < block->count && block->age[i] >= block->lifeTime[i]) {
+                ++i;
+            }
+
+            expired += i;
+            if (i < block->count) {
+                break;
+            }
+        }
+
+        list.retireFront(expired);
+        return;
     }
 
-    for (const auto ptcl : std::views::reverse(m_childParticles)) {
-        ptcl->render(&renderer, params, m_childTexCoords.s, m_childTexCoords.t);
+    // Survivors keep their order for rendering, the ones in front of the first dead particle stay where they are
+    SPLParticleList::Compactor compactor(list, firstDead);
+    const auto blocks = list.getBlocks();
+    const auto first = list.locate(firstDead);
+    for (size_t b = first.block; b < blocks.size(); ++b) {
+        const auto block = blocks[b];
+        for (u32 i = b == first.block ? first.index : 0; i < block->count; ++i) {
+            if (block->age[i] < block->lifeTime[i]) {
+                compactor.keep(*block, i);
+            }
+        }
     }
+
+    compactor.finish();
 }
 
 void SPLEmitter::emit(u32 count) {
     const auto& header = m_resource->header;
 
+    SPLEmissionShape shape = {
+        .type = header.flags.emissionType,
+        .radius = header.radius,
+        .length = header.length,
+    };
+
     switch (header.flags.emissionType) {
     case SPLEmissionType::Point: [[fallthrough]];
     case SPLEmissionType::Sphere: [[fallthrough]];
@@ -280,204 +566,366 @@ void SPLEmitter::emit(u32 count) {
     case SPLEmissionType::HemisphereSurface: [[fallthrough]];
     case SPLEmissionType::Hemisphere:
         computeOrthogonalAxes();
+        shape.axis1 = m_crossAxis1;
+        shape.axis2 = m_crossAxis2;
+        shape.up = glm::normalize(glm::cross(m_crossAxis1, m_crossAxis2));
         break;
     }
 
-    constexpr auto nonzero = [](f32 x) { return x == 0.0f ? FX32_F32_EPSILON : x; };
+    const u32 first = m_particles.size();
+    const u32 end = first + reserveSpawns(m_particles, count);
+    const auto blocks = m_particles.getBlocks();
 
-    for (u32 i = 0; i < count; ++i) {
-        const auto ptcl = m_system->allocateParticle();
-        if (!ptcl) {
-            return;
-        }
+    // Initialized in runs that fill up one block at a time
+    u32 write = first;
+    u32 emitted = 0;
+    while (write < end) {
+        const auto location = m_particles.locate(write);
+        const u32 run = std::min(SPLParticleBlock::CAPACITY - location.index, end - write);
 
-        m_particles.push_back(ptcl);
-        ptcl->emitter = this;
-
-        switch (header.flags.emissionType) {
-        case SPLEmissionType::Point: {
-            ptcl->position = {};
-        } break;
-
-        case SPLEmissionType::SphereSurface: {
-            ptcl->position = glm::sphericalRand(nonzero(header.radius));
-        } break;
-
-        case SPLEmissionType::CircleBorder: {
-            ptcl->position = tiltCoordinates({ glm::circularRand(nonzero(header.radius)), 0 });
-        } break;
-
-        case SPLEmissionType::CircleBorderUniform: {
-            const f32 angle = glm::mix(0.0f, glm::two_pi<f32>(), (f32)i / (f32)count);
-            ptcl->position = tiltCoordinates({ 
-                glm::sin(angle) * header.radius,
-                glm::cos(angle) * header.radius,
-                0
-            });
-        } break;
-
-        case SPLEmissionType::Sphere: {
-            ptcl->position = glm::ballRand(nonzero(header.radius));
-        } break;
-
-        case SPLEmissionType::Circle: {
-            ptcl->position = tiltCoordinates({ glm::diskRand(nonzero(header.radius)), 0 });
-        } break;
-
-        case SPLEmissionType::CylinderSurface: {
-            ptcl->position = tiltCoordinates({
-                glm::circularRand(nonzero(header.radius)),
-                glm::linearRand(-header.length, header.length),
-            });
-        } break;
-
-        case SPLEmissionType::Cylinder: {
-            ptcl->position = tiltCoordinates({
-                glm::diskRand(nonzero(header.radius)),
-                glm::linearRand(-header.length, header.length),
-            });
-        } break;
-
-        case SPLEmissionType::HemisphereSurface: {
-            ptcl->position = glm::sphericalRand(nonzero(header.radius));
-            const auto emitterUp = glm::cross(m_crossAxis1, m_crossAxis2);
-            if (glm::dot(ptcl->position, emitterUp) <= 0) {
-                ptcl->position = -ptcl->position;
-            }
-        } break;
+        initParticles(*blocks[location.block], location.index, location.index + run, shape, emitted, count);
+        write += run;
+        emitted += run;
+    }
 
-        case SPLEmissionType::Hemisphere: {
-            ptcl->position = glm::ballRand(nonzero(header.radius));
-            const auto emitterUp = glm::cross(m_crossAxis1, m_crossAxis2);
-            if (glm::dot(ptcl->position, emitterUp) <= 0) {
-                ptcl->position = -ptcl->position;
-            }
-        } break;
-        }
+    m_particles.checkExpiryOrder(first);
+}
+
+void SPLEmitter::initParticles(SPLParticleBlock& block, u32 begin, u32 end, const SPLEmissionShape& shape, u32 first, u32 total) {
+    const auto& header = m_resource->header;
+    const u32 count = end - begin;
 
-        const f32 magPos = SPLRandom::scaledRange2(header.initVelPosAmplifier, header.variance.initVel);
-        const f32 magAxis = SPLRandom::scaledRange2(header.initVelAxisAmplifier, header.variance.initVel);
+    SPLShapeSampler::sample(shape, block.position + begin, first, count, total);
 
+    alignas(32) f32 magPos[SPLParticleBlock::CAPACITY];
+    alignas(32) f32 magAxis[SPLParticleBlock::CAPACITY];
+    SPLRandom::fillRange({ magPos, count }, header.initVelPosAmplifier, header.initVelPosAmplifier * (1.0f + header.variance.initVel));
+    SPLRandom::fillRange({ magAxis, count }, header.initVelAxisAmplifier, header.initVelAxisAmplifier * (1.0f + header.variance.initVel));
+
+    for (u32 i = 0; i < count; ++i) {
+        const glm::vec3 position = block.position[begin + i];
+
+        // Cylinder surface particles are pushed straight out from the axis
         glm::vec3 posNorm;
-        if (header.flags.emissionType == SPLEmissionType::CylinderSurface) {
-            posNorm = glm::normalize(ptcl->velocity.x * m_crossAxis1 + ptcl->velocity.y * m_crossAxis2);
-        } else if (ptcl->position == glm::vec3(0)) {
+        if (shape.type == SPLEmissionType::CylinderSurface) {
+            posNorm = glm::normalize(position - glm::dot(position, shape.up) * shape.up);
+        } else if (position == glm::vec3(0)) {
             posNorm = SPLRandom::unitVector();
         } else {
-            posNorm = glm::normalize(ptcl->position);
+            posNorm = glm::normalize(position);
         }
 
-        ptcl->velocity = posNorm * magPos + m_axis * magAxis + m_particleInitVelocity;
-        ptcl->emitterPos = m_position;
+        block.velocity[begin + i] = posNorm * magPos[i] + m_axis * magAxis[i] + m_particleInitVelocity;
+    }
 
-        ptcl->baseScale = SPLRandom::scaledRange2(header.baseScale, header.variance.baseScale);
-        ptcl->animScale = 1.0f;
+    std::fill(block.emitterPos + begin, block.emitterPos + end, m_position);
 
-        if (header.flags.hasColorAnim && m_resource->colorAnim && m_resource->colorAnim->flags.randomStartColor) {
-            const glm::vec3 startColors[3] = {
-                m_resource->colorAnim->start,
-                header.color,
-                m_resource->colorAnim->end
-            };
+    const f32 baseScale = header.baseScale;
+    SPLRandom::fillRange({ block.baseScale + begin, count }, baseScale, baseScale * (1.0f + header.variance.baseScale));
+    std::fill(block.animScale + begin, block.animScale + end, 1.0f);
 
-            ptcl->color = startColors[SPLRandom::nextU32() % 3];
-        } else {
-            ptcl->color = header.color;
+    if (header.flags.hasColorAnim && m_resource->colorAnim && m_resource->colorAnim->flags.randomStartColor) {
+        const glm::vec3 startColors[3] = {
+            m_resource->colorAnim->start,
+            header.color,
+            m_resource->colorAnim->end
+        };
+
+        for (u32 i = begin; i < end; ++i) {
+            block.color[i] = startColors[SPLRandom::nextU32() % 3];
         }
+    } else {
+        std::fill(block.color + begin, block.color + end, header.color);
+    }
 
-        ptcl->visibility.baseAlpha = header.misc.baseAlpha;
-        ptcl->visibility.animAlpha = 1.0f;
+    std::fill(block.baseAlpha + begin, block.baseAlpha + end, header.misc.baseAlpha);
+    std::fill(block.animAlpha + begin, block.animAlpha + end, 1.0f);
 
-        if (header.flags.randomInitAngle) {
-            ptcl->rotation = SPLRandom::range(0.0f, glm::two_pi<f32>());
-        } else {
-            ptcl->rotation = header.initAngle;
-        }
+    if (header.flags.randomInitAngle) {
+        SPLRandom::fillRange({ block.rotation + begin, count }, 0.0f, glm::two_pi<f32>());
+    } else {
+        std::fill(block.rotation + begin, block.rotation + end, header.initAngle);
+    }
 
-        if (header.flags.hasRotation) {
-            ptcl->angularVelocity = SPLRandom::range(header.minRotation, header.maxRotation);
-        } else {
-            ptcl->angularVelocity = 0;
-        }
+    if (header.flags.hasRotation) {
+        SPLRandom::fillRange({ block.angularVelocity + begin, count }, header.minRotation, header.maxRotation);
+    } else {
+        std::fill(block.angularVelocity + begin, block.angularVelocity + end, 0.0f);
+    }
 
-        ptcl->lifeTime = SPLRandom::scaledRange(header.particleLifeTime, header.variance.lifeTime);
-        ptcl->age = 0;
-        ptcl->emissionTimer = 0;
+    // Same range as SPLRandom::scaledRange
+    const f32 lifeTimeVariance = glm::clamp(header.variance.lifeTime, 0.0f, 1.0f);
+    SPLRandom::fillRange(
+        { block.lifeTime + begin, count },
+        header.particleLifeTime * (1.0f - lifeTimeVariance / 2.0f),
+        header.particleLifeTime * (1.0f + lifeTimeVariance / 2.0f)
+    );
+
+    for (u32 i = begin; i < end; ++i) {
+        block.lifeTimeFactor[i] = SPLParticleBlock::computeRateFactor(block.lifeTime[i]);
+    }
 
-        if (header.flags.hasTexAnim && m_resource->texAnim) {
-            const auto& texAnim = m_resource->texAnim.value();
-            if (m_resource->texAnim->param.randomizeInit) {
-                ptcl->texture = texAnim.textures[SPLRandom::nextU32() % texAnim.param.textureCount];
-            } else {
-                ptcl->texture = texAnim.textures[0];
+    std::fill(block.age + begin, block.age + end, 0.0f);
+    std::fill(block.emissionTimer + begin, block.emissionTimer + end, 0.0f);
+
+    if (header.flags.hasTexAnim && m_resource->texAnim) {
+        const auto& texAnim = m_resource->texAnim.value();
+        if (texAnim.param.randomizeInit) {
+            for (u32 i = begin; i < end; ++i) {
+                block.texture[i] = texAnim.textures[SPLRandom::nextU32() % texAnim.param.textureCount];
             }
         } else {
-            ptcl->texture = header.misc.textureIndex;
+            std::fill(block.texture + begin, block.texture + end, texAnim.textures[0]);
         }
-        
-        ptcl->lifeRateOffset = header.flags.randomizeLoopedAnim ? SPLRandom::nextF32() : 0;
+    } else {
+        std::fill(block.texture + begin, block.texture + end, header.misc.textureIndex);
+    }
+
+    if (header.flags.randomizeLoopedAnim) {
+        SPLRandom::fill({ block.lifeRateOffset + begin, count });
+    } else {
+        std::fill(block.lifeRateOffset + begin, block.lifeRateOffset + end, 0.0f);
+    }
+
+    for (u32 i = begin; i < end; ++i) {
+        block.beginStep(i);
     }
 }
 
-void SPLEmitter::emitChildren(const SPLParticle& parent, u32 count) {
-    if (!m_resource->childResource) {
+void SPLEmitter::emitChildren() {
+    u32 requested = 0;
+    for (const auto& childSpawns : m_childSpawns) {
+        for (const auto& spawn : childSpawns) {
+            requested += spawn.count;
+        }
+    }
+
+    if (requested == 0) {
         return;
     }
 
+    // Reserve every child up front, if the budget runs out the earliest parents get theirs
+    const u32 first = m_childParticles.size();
+    const u32 end = first + reserveSpawns(m_childParticles, requested);
+
+    const auto parentBlocks = m_particles.getBlocks();
+    const auto childBlocks = m_childParticles.getBlocks();
+
+    u32 write = first;
+    for (const auto& childSpawns : m_childSpawns) {
+        for (const auto& spawn : childSpawns) {
+            if (write == end) {
+                break;
+            }
+
+            const auto parent = m_particles.locate(spawn.particle);
+
+            // The children of one parent may straddle a block boundary
+            u32 remaining = spawn.count;
+            while (remaining > 0 && write < end) {
+                const auto location = m_childParticles.locate(write);
+                const u32 count = std::min({ remaining, SPLParticleBlock::CAPACITY - location.index, end - write });
+
+                initChildren(
+                    *parentBlocks[parent.block], parent.index,
+                    *childBlocks[location.block], location.index, location.index + count
+                );
+
+                write += count;
+                remaining -= count;
+            }
+        }
+    }
+
+    // Children share one life time, they stay in expiry order unless it was edited in between
+    m_childParticles.checkExpiryOrder(first);
+}
+
+void SPLEmitter::initChildren(const SPLParticleBlock& parent, u32 parentIndex, SPLParticleBlock& block, u32 begin, u32 end) {
     const auto& child = m_resource->childResource.value();
+    const u32 count = end - begin;
+
+    // Everything but the random velocity is the same for all children of a parent
+    const glm::vec3 position = parent.position[parentIndex];
+    const glm::vec3 velocity = parent.velocity[parentIndex] * child.velocityRatio;
+    const glm::vec3 color = child.flags.useChildColor ? child.color : parent.color[parentIndex];
+    const f32 baseScale = parent.baseScale[parentIndex] * parent.animScale[parentIndex] * child.scaleRatio;
+    const f32 baseAlpha = parent.baseAlpha[parentIndex] * parent.animAlpha[parentIndex];
+    const u16 lifeTimeFactor = SPLParticleBlock::computeRateFactor(child.lifeTime);
+
+    f32 rotation = 0;
+    f32 angularVelocity = 0;
+    switch (child.flags.rotationType) {
+    case SPLChildRotationType::None:
+        break;
+    case SPLChildRotationType::InheritAngle:
+        rotation = parent.rotation[parentIndex];
+        break;
+    case SPLChildRotationType::InheritAngleAndVelocity:
+        rotation = parent.rotation[parentIndex];
+        angularVelocity = parent.angularVelocity[parentIndex];
+        break;
+    }
+
+    alignas(32) f32 random[SPLParticleBlock::CAPACITY * 3];
+    SPLRandom::fillN({ random, count * 3 });
 
     for (u32 i = 0; i < count; ++i) {
-        const auto ptcl = m_system->allocateParticle();
-        if (!ptcl) {
-            return;
-        }
+        const glm::vec3 randomVelocity = { random[i * 3], random[i * 3 + 1], random[i * 3 + 2] };
+        block.velocity[begin + i] = velocity + randomVelocity * child.randomInitVelMag;
+    }
 
-        m_childParticles.push_back(ptcl);
-        ptcl->emitter = this;
+    std::fill(block.position + begin, block.position + end, position);
+    std::fill(block.prevPosition + begin, block.prevPosition + end, position);
+    std::fill(block.emitterPos + begin, block.emitterPos + end, m_position);
+    std::fill(block.color + begin, block.color + end, color);
+
+    std::fill(block.rotation + begin, block.rotation + end, rotation);
+    std::fill(block.prevRotation + begin, block.prevRotation + end, rotation);
+    std::fill(block.angularVelocity + begin, block.angularVelocity + end, angularVelocity);
+
+    std::fill(block.baseScale + begin, block.baseScale + end, baseScale);
+    std::fill(block.animScale + begin, block.animScale + end, 1.0f);
+    std::fill(block.baseAlpha + begin, block.baseAlpha + end, baseAlpha);
+    std::fill(block.animAlpha + begin, block.animAlpha + end, 1.0f);
+
+    std::fill(block.lifeTime + begin, block.lifeTime + end, child.lifeTime);
+    std::fill(block.lifeTimeFactor + begin, block.lifeTimeFactor + end, lifeTimeFactor);
+    std::fill(block.age + begin, block.age + end, 0.0f);
+    std::fill(block.emissionTimer + begin, block.emissionTimer + end, 0.0f);
+    std::fill(block.lifeRateOffset + begin, block.lifeRateOffset + end, 0.0f);
+    std::fill(block.texture + begin, block.texture + end, child.misc.texture);
+}
 
-        ptcl->position = parent.position;
-        ptcl->velocity = parent.velocity * child.velocityRatio + glm::vec3(
-            SPLRandom::aroundZero(child.randomInitVelMag),
-            SPLRandom::aroundZero(child.randomInitVelMag),
-            SPLRandom::aroundZero(child.randomInitVelMag)
-        );
+u32 SPLEmitter::reserveSpawns(SPLParticleList& list, u32 count) {
+    const u32 allowed = std::min(count, m_spawnQuota);
+    m_spawnQuota -= allowed;
 
-        ptcl->emitterPos = m_position;
+    const u32 added = list.append(allowed);
+    if (added < count) {
+        m_deniedSpawns += count - added;
+        m_system->reportDeniedSpawns(count - added);
+    }
 
-        ptcl->baseScale = parent.baseScale * parent.animScale * child.scaleRatio;
-        ptcl->animScale = 1.0f;
+    return added;
+}
 
-        if (child.flags.useChildColor) {
-            ptcl->color = child.color;
-        } else {
-            ptcl->color = parent.color;
+void SPLEmitter::updateBounds() {
+    glm::vec3 min(std::numeric_limits<f32>::max());
+    glm::vec3 max(std::numeric_limits<f32>::lowest());
+    f32 maxScale = 0.0f;
+
+    for (const auto list : { &m_particles, &m_childParticles }) {
+        for (const auto block : list->getBlocks()) {
+            for (u32 i = 0; i < block->count; ++i) {
+                const glm::vec3 position = block->emitterPos[i] + block->position[i];
+                const glm::vec3 prevPosition = block->emitterPos[i] + block->prevPosition[i];
+                min = glm::min(min, glm::min(position, prevPosition));
+                max = glm::max(max, glm::max(position, prevPosition));
+
+                // Scale animations may only apply to one axis, assuming both is conservative
+                maxScale = std::max(maxScale, block->baseScale[i] * std::max(block->animScale[i], 1.0f));
+            }
         }
+    }
 
-        ptcl->visibility.baseAlpha = parent.visibility.baseAlpha * parent.visibility.animAlpha;
-        ptcl->visibility.animAlpha = 1.0f;
+    // Quads span [-scale, scale] and can be rotated freely, so pad by the half diagonal
+    const f32 extent = maxScale * std::max(m_resource->header.aspectRatio, 1.0f) * glm::root_two<f32>();
+    m_bounds = { min - extent, max + extent };
+}
+
+void SPLEmitter::updateBehaviorTimers() {
+    const f64 time = m_system->getTime();
+
+    m_applyRandomBehavior = false;
+    for (const auto& behavior : m_resource->behaviors) {
+        if (behavior->type == SPLBehaviorType::Random) {
+            const auto& randomBehavior = static_cast<const SPLRandomBehavior&>(*behavior);
+            if (time - m_lastRandomApplication >= randomBehavior.applyInterval) {
+                m_applyRandomBehavior = true;
+                m_lastRandomApplication = time;
+            }
 
-        switch (child.flags.rotationType) {
-        case SPLChildRotationType::None:
-            ptcl->rotation = 0;
-            ptcl->angularVelocity = 0;
-            break;
-        case SPLChildRotationType::InheritAngle:
-            ptcl->rotation = parent.rotation;
-            ptcl->angularVelocity = 0;
-            break;
-        case SPLChildRotationType::InheritAngleAndVelocity:
-            ptcl->rotation = parent.rotation;
-            ptcl->angularVelocity = parent.angularVelocity;
             break;
         }
+    }
+}
 
-        ptcl->lifeTime = child.lifeTime;
-        ptcl->age = 0;
-        ptcl->emissionTimer = 0;
+f64 SPLEmitter::getParentSpawnUpperBound() const {
+    const auto& header = m_resource->header;
+    if (m_state.terminate) {
+        return 0.0;
+    }
 
-        ptcl->texture = child.misc.texture;
-        ptcl->lifeRateOffset = 0;
+    // Mirrors the emission in update
+    if (header.misc.emissionInterval == 0.0f || m_age == 0.0f) {
+        return header.emissionCount;
+    } else if (m_age <= header.emitterLifeTime) {
+        return header.emissionCount * getMaxEmissions(m_emissionTimer, header.misc.emissionInterval);
     }
+
+    return 0.0;
+}
+
+u32 SPLEmitter::getSpawnUpperBound() const {
+    const auto& header = m_resource->header;
+    const f64 parents = getParentSpawnUpperBound();
+
+    if (!header.flags.hasChildResource || !m_resource->childResource) {
+        return saturate(parents);
+    }
+
+    if (m_maxParentEmissionTimer < 0.0f) {
+        return std::numeric_limits<u32>::max();
+    }
+
+    // Every live parent emits at most as often as the latest timer allows, newly emitted parents at most once
+    const auto& child = m_resource->childResource.value();
+    const f64 emissions = parents
+        + m_particles.size() * getMaxEmissions(m_maxParentEmissionTimer, child.misc.emissionInterval);
+
+    return saturate(parents + emissions * child.misc.emissionCount);
+}
+
+u32 SPLEmitter::getExactSpawnUpperBound() const {
+    const auto& header = m_resource->header;
+    if (!header.flags.hasChildResource || !m_resource->childResource) {
+        return getSpawnUpperBound();
+    }
+
+    const f64 parents = getParentSpawnUpperBound();
+    const auto& child = m_resource->childResource.value();
+    f64 emissions = parents;
+    for (const auto block : m_particles.getBlocks()) {
+        for (u32 i = 0; i < block->count; ++i) {
+            emissions += getMaxEmissions(block->emissionTimer[i], child.misc.emissionInterval);
+        }
+    }
+
+    return saturate(parents + emissions * child.misc.emissionCount);
+}
+
+f32 SPLEmitter::getIdleTime() const {
+    const auto& header = m_resource->header;
+
+    if (!m_particles.empty() || !m_childParticles.empty() || m_state.terminate
+        || header.misc.emissionInterval == 0.0f || m_age == 0.0f) {
+        return 0.0f;
+    }
+
+    // Mirrors update: the next emission happens once the timer reaches the interval, if that is still within the
+    // emitter's life time, and looping emitters start over (emitting right away) once they outlive it
+    f32 idle = std::numeric_limits<f32>::infinity();
+    const f32 nextEmission = std::max(header.misc.emissionInterval - m_emissionTimer, 0.0f);
+    if (m_age + nextEmission <= header.emitterLifeTime) {
+        idle = nextEmission;
+    }
+
+    if (m_state.looping) {
+        idle = std::min(idle, std::max(header.emitterLifeTime - m_age, 0.0f));
+    }
+
+    return idle;
 }
 
 bool SPLEmitter::shouldTerminate() const {
@@ -527,8 +975,3 @@ void SPLEmitter::computeOrthogonalAxes() {
     m_crossAxis1 = glm::normalize(glm::cross(axis, crossVector));
     m_crossAxis2 = glm::normalize(glm::cross(axis, m_crossAxis1));
 }
-
-glm::vec3 SPLEmitter::tiltCoordinates(const glm::vec3& vec) const {
-    const glm::vec3 axis3 = glm::normalize(glm::cross(m_crossAxis1, m_crossAxis2));
-    return vec.x * m_crossAxis1 + vec.y * m_crossAxis2 + vec.z * axis3;
-}
@@ -2,12 +2,15 @@
 
 #include "spl_resource.h"
 #include "spl_particle.h"
+#include "spl_random.h"
 #include "types.h"
 
+#include <limits>
+#include <span>
 #include <vector>
 
 class ParticleSystem;
-struct CameraParams;
+struct SPLEmissionShape;
 
 struct SPLEmitterState {
     bool terminate;
@@ -18,19 +21,53 @@ struct SPLEmitterState {
     bool looping;
 };
 
+// Axis aligned box in world space
+struct SPLBounds {
+    glm::vec3 min;
+    glm::vec3 max;
+};
+
 class SPLEmitter {
 public:
     explicit SPLEmitter(const SPLResource *resource, ParticleSystem* system, bool looping = false, const glm::vec3& pos = {});
     ~SPLEmitter();
 
+    // Emitters are stored by value in the particle system and move around as others are removed
+    SPLEmitter(SPLEmitter&&) noexcept = default;
+    SPLEmitter& operator=(SPLEmitter&&) noexcept = default;
+    SPLEmitter& operator=(const SPLEmitter&) = delete;
+
     void update(float deltaTime);
-    void render(const CameraParams& params);
     void emit(u32 count);
-    void emitChildren(const SPLParticle& parent, u32 count);
 
     bool shouldTerminate() const;
 
+    // Upper bound on the number of particles the next update can spawn, O(1).
+    // Child spawns are bounded by the latest emission timer of any parent, so the bound can be loose.
+    u32 getSpawnUpperBound() const;
+
+    // Tighter upper bound that looks at the emission timer of every parent particle, O(particles)
+    u32 getExactSpawnUpperBound() const;
+
+    // Weight of this emitter when the particle system splits a short budget between emitters, see BudgetPolicy.
+    // Can be used to favor important emitters, for example the ones closest to the camera.
+    void setPriority(f32 priority) { m_priority = priority; }
+    f32 getPriority() const { return m_priority; }
+
+    // Whether the emitter was in view when last rendered, off-screen emitters update less often under an update budget
+    void setVisible(bool visible) { m_visible = visible; }
+    bool isVisible() const { return m_visible; }
+
+    // Number of particles this emitter wanted to spawn but wasn't allowed to, over its whole life
+    u64 getDeniedSpawns() const { return m_deniedSpawns; }
+
     const SPLResource* getResource() const { return m_resource; }
+    const SPLParticleList& getParticles() const { return m_particles; }
+    const SPLParticleList& getChildParticles() const { return m_childParticles; }
+    bool isRenderingDisabled() const { return m_state.renderingDisabled; }
+
+    glm::vec2 getTexCoords() const { return m_texCoords; }
+    glm::vec2 getChildTexCoords() const { return m_childTexCoords; }
 
     glm::vec3 getPosition() const { return m_position; }
     glm::vec3 getVelocity() const { return m_velocity; }
@@ -38,25 +75,143 @@ public:
     f32 getRadius() const { return m_radius; }
     f32 getLength() const { return m_length; }
 
+    // Box around every particle quad as of the last update, covering both ends of the step for render interpolation.
+    // Only meaningful while the emitter has particles.
+    const SPLBounds& getBounds() const { return m_bounds; }
+
+    // True if random behaviors are due in the current update, they fire for all particles at once
+    bool shouldApplyRandomBehavior() const { return m_applyRandomBehavior; }
+
+    // Resource features the particle loop is specialized on. Every combination is compiled into its own kernel,
+    // so disabled features cost neither branches nor calls per particle.
+    enum KernelFeature : u32 {
+        KernelScaleAnim = 1u << 0,
+        KernelColorAnim = 1u << 1,
+        KernelAlphaAnim = 1u << 2,
+        KernelTexAnim = 1u << 3,
+        KernelFollowEmitter = 1u << 4,
+        KernelChildren = 1u << 5,
+    };
+
+    // Same for the child particle loop
+    enum ChildKernelFeature : u32 {
+        ChildKernelScaleAnim = 1u << 0,
+        ChildKernelAlphaAnim = 1u << 1,
+        ChildKernelFollowEmitter = 1u << 2,
+    };
+
+    static constexpr u32 PARTICLE_KERNEL_COUNT = 1u << 6;
+    static constexpr u32 CHILD_KERNEL_COUNT = 1u << 3;
+
+    // Feature masks the kernels for this emitter's resource are picked by, they follow edits to the resource
+    u32 getKernelFeatures() const;
+    u32 getChildKernelFeatures() const;
+
+    // Number of emitter updates that ran the kernel for a feature mask, over all emitters since the program started
+    static u64 getParticleKernelUsage(u32 features);
+    static u64 getChildKernelUsage(u32 features);
+
 private:
+    // Copies the complete emitter state except for the particles, which live in the pool
+    SPLEmitter(const SPLEmitter& other);
+
+    // Number of blocks simulated together as one unit of work, large emitters are split into several chunks
+    static constexpr u32 CHUNK_BLOCKS = 16;
+
+    static constexpr u32 NO_DEAD = ~0u;
+
+    struct ChildSpawn {
+        u32 particle; // Index of the parent particle in m_particles
+        u32 count;
+    };
+
+    // Loop invariants of the kernels, resolved once per update
+    struct KernelArgs {
+        const SPLScaleAnim* scaleAnim;
+        const SPLColorAnim* colorAnim;
+        const SPLAlphaAnim* alphaAnim;
+        const SPLTexAnim* texAnim;
+        const SPLChildResource* child;
+
+        // Index of the life rate each animation uses, 0 = non-looping, 1 = looping
+        u8 scaleLoop;
+        u8 colorLoop;
+        u8 alphaLoop;
+        u8 texLoop;
+
+        u16 loopTimeFactor; // From the resource's current loop time, see SPLParticleBlock::getLoopRate
+
+        f32 deltaTime;
+    };
+
+    // Simulates one chunk of m_particles, collecting child spawns in m_childSpawns[chunk]
+    template<u32 Features>
+    void updateParticles(const KernelArgs& args, std::span<SPLParticleBlock* const> blocks, u32 chunk);
+
+    template<u32 Features>
+    void updateChildParticles(const KernelArgs& args, std::span<SPLParticleBlock* const> blocks, u32 chunk);
+
+    static u32 getChunkCount(const SPLParticleList& list);
+
+    // Calls fn(blocks, chunkIndex) for every chunk of the list, in parallel if possible
+    template<typename Fn>
+    void forEachChunk(const SPLParticleList& list, Fn&& fn);
+
+    // Position of the first dead particle in a block that starts at `blockStart`, or NO_DEAD
+    static u32 findFirstDead(const SPLParticleBlock& block, u32 blockStart);
+
+    // Removes the particles that died in the last kernel pass over the list, as recorded in m_chunkFirstDead.
+    // `killed` is set if particles may have died before their time, out of expiry order.
+    void retireDeadParticles(SPLParticleList& list, bool killed);
+
+    // Most parent particles the next update can emit, before any budget
+    f64 getParentSpawnUpperBound() const;
+
+    // Time, in seconds, the emitter can go without updates because nothing would happen but aging.
+    // 0 while it has particles or is about to emit, infinity if it never does anything again.
+    f32 getIdleTime() const;
+
+    // Appends up to `count` particles to the list within this update's spawn quota, returns how many were added
+    u32 reserveSpawns(SPLParticleList& list, u32 count);
+
+    // Spawns all children requested in m_childSpawns at once, in parent order
+    void emitChildren();
+
+    // Initializes the children at [begin, end) of `block` from one parent
+    void initChildren(const SPLParticleBlock& parent, u32 parentIndex, SPLParticleBlock& block, u32 begin, u32 end);
+
+    void updateBehaviorTimers();
+    void updateBounds();
     void computeOrthogonalAxes();
-    glm::vec3 tiltCoordinates(const glm::vec3& vec) const;
+
+    // Initializes the freshly emitted particles at [begin, end) of `block`,
+    // which are particles [first, first + end - begin) of an emission of `total`
+    void initParticles(SPLParticleBlock& block, u32 begin, u32 end, const SPLEmissionShape& shape, u32 first, u32 total);
 
 private:
     const SPLResource *m_resource;
     ParticleSystem* m_system;
 
-    std::vector<SPLParticle*> m_particles;
-    std::vector<SPLParticle*> m_childParticles;
+    SPLParticleList m_particles;
+    SPLParticleList m_childParticles;
+    std::vector<std::vector<ChildSpawn>> m_childSpawns; // Child spawns requested by each chunk during update
+    std::vector<f32> m_chunkEmissionTimers; // Latest parent emission timer of each chunk after update
+    std::vector<u32> m_chunkFirstDead; // First dead particle of each chunk after the last kernel pass, or NO_DEAD
 
     SPLEmitterState m_state;
 
+    // Private random stream, all random numbers during update are drawn from it
+    SPLRandom::Generator m_random;
+
     glm::vec3 m_position;
     glm::vec3 m_velocity;
     glm::vec3 m_particleInitVelocity;
 
     f32 m_age; // age of the emitter, in seconds
     f32 m_emissionTimer; // time, in seconds, since the last emission
+    f64 m_lastRandomApplication; // simulation time of the last random behavior application
+    bool m_applyRandomBehavior = false;
+    f32 m_maxParentEmissionTimer = 0.0f; // upper bound on the emission timers of m_particles, negative if unknown
 
     glm::vec3 m_axis;
     f32 m_initAngle;
@@ -74,7 +229,18 @@ private:
 
     f32 m_emissionInterval; // time, in seconds, between particle emissions
     f32 m_baseAlpha;
-    u8 m_updateCycle; // 0 = every frame, 1 = cycle A, 2 = cycle B, cycles A and B alternate
+    u8 m_updateCycle; // 0 = scheduled by the particle system, 1 = cycle A, 2 = cycle B, cycles A and B alternate
+    u64 m_lastStep = 0; // simulation step this emitter was last updated in
+    f32 m_pendingTime = 0.0f; // time, in seconds, the next update has to simulate
+    bool m_visible = true;
+    bool m_sleeping = false; // waiting on a timer in the particle system instead of being updated
+    f64 m_sleepStart = 0.0; // simulation time the emitter went to sleep at
+
+    SPLBounds m_bounds = {};
+
+    f32 m_priority = 1.0f;
+    u32 m_spawnQuota = std::numeric_limits<u32>::max(); // particles this emitter may still spawn in the current update
+    u64 m_deniedSpawns = 0;
 
     glm::vec3 m_crossAxis1;
     glm::vec3 m_crossAxis2;
@@ -0,0 +1,192 @@
+#include "spl_integrate.h"
+#include "spl_particle.h"
+#include "spl_simd.h"
+
+#include <algorithm>
+
+namespace {
+
+// Components of the vec3 streams, as flat arrays
+f32* components(glm::vec3* vec) {
+    return &vec->x;
+}
+
+const f32* components(const glm::vec3* vec) {
+    return &vec->x;
+}
+
+// Integrates particles [begin, end), also the tail for the vector kernels
+void integrateScalar(SPLParticleBlock& block, u32 begin, u32 end, const glm::vec3* acceleration, f32 airResistance, const glm::vec3& emitterVelocity, f32 dt) {
+    for (u32 i = begin; i < end; ++i) {
+        block.rotation[i] += block.angularVelocity[i] * dt;
+
+        block.velocity[i] *= airResistance;
+        block.velocity[i] += acceleration[i] * dt;
+
+        block.position[i] += (block.velocity[i] + emitterVelocity) * dt;
+
+        block.age[i] += dt;
+        block.emissionTimer[i] += dt;
+    }
+}
+
+#if SPL_X64
+
+SPL_TARGET("sse4.1")
+void integrateSSE41(SPLParticleBlock& block, const glm::vec3* acceleration, f32 airResistance, const glm::vec3& emitterVelocity, f32 dt) {
+    constexpr u32 LANES = 4;
+
+    const u32 count = block.count;
+    const u32 vectorCount = count / LANES * LANES;
+
+    const __m128 vdt = _mm_set1_ps(dt);
+    const __m128 vair = _mm_set1_ps(airResistance);
+
+    for (u32 i = 0; i < vectorCount; i += LANES) {
+        _mm_storeu_ps(&block.rotation[i], _mm_add_ps(_mm_loadu_ps(&block.rotation[i]), _mm_mul_ps(_mm_loadu_ps(&block.angularVelocity[i]), vdt)));
+        _mm_storeu_ps(&block.age[i], _mm_add_ps(_mm_loadu_ps(&block.age[i]), vdt));
+        _mm_storeu_ps(&block.emissionTimer[i], _mm_add_ps(_mm_loadu_ps(&block.emissionTimer[i]), vdt));
+    }
+
+    // 4 particles are 12 floats, so the emitter velocity repeats every 3 registers
+    const auto& ev = emitterVelocity;
+    const __m128 evPattern[3] = {
+        _mm_setr_ps(ev.x, ev.y, ev.z, ev.x),
+        _mm_setr_ps(ev.y, ev.z, ev.x, ev.y),
+        _mm_setr_ps(ev.z, ev.x, ev.y, ev.z),
+    };
+
+    f32* position = components(block.position);
+    f32* velocity = components(block.velocity);
+    const f32* acc = components(acceleration);
+
+    for (u32 i = 0; i < vectorCount * 3; i += LANES * 3) {
+        for (u32 k = 0; k < 3; ++k) {
+            const u32 j = i + k * LANES;
+
+            __m128 v = _mm_mul_ps(_mm_loadu_ps(velocity + j), vair);
+            v = _mm_add_ps(v, _mm_mul_ps(_mm_loadu_ps(acc + j), vdt));
+            _mm_storeu_ps(velocity + j, v);
+
+            const __m128 p = _mm_add_ps(_mm_loadu_ps(position + j), _mm_mul_ps(_mm_add_ps(v, evPattern[k]), vdt));
+            _mm_storeu_ps(position + j, p);
+        }
+    }
+
+    integrateScalar(block, vectorCount, count, acceleration, airResistance, emitterVelocity, dt);
+}
+
+SPL_TARGET("avx2")
+void integrateAVX2(SPLParticleBlock& block, const glm::vec3* acceleration, f32 airResistance, const glm::vec3& emitterVelocity, f32 dt) {
+    constexpr u32 LANES = 8;
+
+    const u32 count = block.count;
+    const u32 vectorCount = count / LANES * LANES;
+
+    const __m256 vdt = _mm256_set1_ps(dt);
+    const __m256 vair = _mm256_set1_ps(airResistance);
+
+    for (u32 i = 0; i < vectorCount; i += LANES) {
+        _mm256_storeu_ps(&block.rotation[i], _mm256_add_ps(_mm256_loadu_ps(&block.rotation[i]), _mm256_mul_ps(_mm256_loadu_ps(&block.angularVelocity[i]), vdt)));
+        _mm256_storeu_ps(&block.age[i], _mm256_add_ps(_mm256_loadu_ps(&block.age[i]), vdt));
+        _mm256_storeu_ps(&block.emissionTimer[i], _mm256_add_ps(_mm256_loadu_ps(&block.emissionTimer[i]), vdt));
+    }
+
+    // 8 particles are 24 floats, so the emitter velocity repeats every 3 registers
+    const auto& ev = emitterVelocity;
+    const __m256 evPattern[3] = {
+        _mm256_setr_ps(ev.x, ev.y, ev.z, ev.x, ev.y, ev.z, ev.x, ev.y),
+        _mm256_setr_ps(ev.z, ev.x, ev.y, ev.z, ev.x, ev.y, ev.z, ev.x),
+        _mm256_setr_ps(ev.y, ev.z, ev.x, ev.y, ev.z, ev.x, ev.y, ev.z),
+    };
+
+    f32* position = components(block.position);
+    f32* velocity = components(block.velocity);
+    const f32* acc = components(acceleration);
+
+    for (u32 i = 0; i < vectorCount * 3; i += LANES * 3) {
+        for (u32 k = 0; k < 3; ++k) {
+            const u32 j = i + k * LANES;
+
+            __m256 v = _mm256_mul_ps(_mm256_loadu_ps(velocity + j), vair);
+            v = _mm256_add_ps(v, _mm256_mul_ps(_mm256_loadu_ps(acc + j), vdt));
+            _mm256_storeu_ps(velocity + j, v);
+
+            const __m256 p = _mm256_add_ps(_mm256_loadu_ps(position + j), _mm256_mul_ps(_mm256_add_ps(v, evPattern[k]), vdt));
+            _mm256_storeu_ps(position + j, p);
+        }
+    }
+
+    // The rest of the program is SSE code, leaving the upper halves dirty makes every transition expensive
+    _mm256_zeroupper();
+
+    integrateScalar(block, vectorCount, count, acceleration, airResistance, emitterVelocity, dt);
+}
+
+#endif
+
+}
+
+void SPLIntegrator::integrate(SPLParticleBlock& block, const glm::vec3* acceleration, f32 airResistance, const glm::vec3& emitterVelocity, f32 dt) {
+    switch (s_level) {
+#if SPL_X64
+    case SPLSimdLevel::AVX2:
+        integrateAVX2(block, acceleration, airResistance, emitterVelocity, dt);
+        break;
+    case SPLSimdLevel::SSE41:
+        integrateSSE41(block, acceleration, airResistance, emitterVelocity, dt);
+        break;
+#endif
+    default:
+        integrateScalar(block, 0, block.count, acceleration, airResistance, emitterVelocity, dt);
+        break;
+    }
+}
+
+SPLSimdLevel SPLIntegrator::getSupportedLevel() {
+#if SPL_X64 && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    const int maxLeaf = info[0];
+
+    __cpuid(info, 1);
+    const bool sse41 = (info[2] & (1 << 19)) != 0;
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avxState = osxsave && (_xgetbv(0) & 0x6) == 0x6; // OS saves the YMM registers
+
+    bool avx2 = false;
+    if (maxLeaf >= 7 && avxState) {
+        __cpuidex(info, 7, 0);
+        avx2 = (info[1] & (1 << 5)) != 0;
+    }
+
+    return avx2 ? SPLSimdLevel::AVX2 : sse41 ? SPLSimdLevel::SSE41 : SPLSimdLevel::Scalar;
+#elif SPL_X64
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return SPLSimdLevel::AVX2;
+    }
+
+    if (__builtin_cpu_supports("sse4.1")) {
+        return SPLSimdLevel::SSE41;
+    }
+
+    return SPLSimdLevel::Scalar;
+#else
+    return SPLSimdLevel::Scalar;
+#endif
+}
+
+void SPLIntegrator::setLevel(SPLSimdLevel level) {
+    s_level = std::min(level, getSupportedLevel());
+}
+
+const char* SPLIntegrator::getLevelName(SPLSimdLevel level) {
+    switch (level) {
+    case SPLSimdLevel::Scalar: return "scalar";
+    case SPLSimdLevel::SSE41: return "sse4.1";
+    case SPLSimdLevel::AVX2: return "avx2";
+    }
+
+    return "unknown";
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "types.h"
+
+#include <glm/glm.hpp>
+
+struct SPLParticleBlock;
+
+enum class SPLSimdLevel {
+    Scalar,
+    SSE41,
+    AVX2,
+};
+
+// Integrates particle motion for a whole block at a time.
+// The vec3 streams of a block are contiguous floats, so the kernels treat them as flat arrays
+// and process 4 (SSE) or 8 (AVX2) components per instruction. The best kernel the CPU supports
+// is picked at runtime, all kernels produce bit-identical results.
+class SPLIntegrator {
+public:
+    // Applies one step of motion to particles [0, block.count):
+    // rotation, velocity (air resistance, acceleration), position, age and emission timer.
+    // `acceleration` holds one value per particle.
+    static void integrate(SPLParticleBlock& block, const glm::vec3* acceleration, f32 airResistance, const glm::vec3& emitterVelocity, f32 dt);
+
+    static SPLSimdLevel getSupportedLevel();
+    static SPLSimdLevel getLevel() { return s_level; }
+
+    // Forces a specific kernel, levels above the supported one fall back to it
+    static void setLevel(SPLSimdLevel level);
+
+    // Short lowercase name of the instruction set, e.g. "avx2"
+    static const char* getLevelName(SPLSimdLevel level);
+
+private:
+    static inline SPLSimdLevel s_level = getSupportedLevel();
+};
@@ -1,123 +1,281 @@
 #include "spl_particle.h"
-#include "editor/camera.h"
-#include "editor/particle_renderer.h"
-#include "spl_emitter.h"
-
-#include <glm/ext/matrix_transform.hpp>
-#include <glm/gtx/norm.hpp>
-
-
-
-void SPLParticle::render(ParticleRenderer* renderer, const CameraParams& params, f32 s, f32 t) const {
-    switch (emitter->getResource()->header.flags.drawType) {
-    case SPLDrawType::Billboard:
-        renderBillboard(renderer, params, s, t);
-        break;
-    case SPLDrawType::DirectionalBillboard:
-        renderDirectionalBillboard(renderer, params, s, t);
-        break;
-    case SPLDrawType::Polygon:
-        break;
-    case SPLDrawType::DirectionalPolygon:
-        break;
-    case SPLDrawType::DirectionalPolygonCenter:
-        break;
-    }
-}
-
-glm::vec3 SPLParticle::getWorldPosition() const {
-    return emitterPos + position;
-}
-
-void SPLParticle::renderBillboard(ParticleRenderer* renderer, const CameraParams& params, f32 s, f32 t) const {
-    const SPLResource* resource = emitter->getResource();
-    glm::vec3 scale = { baseScale * resource->header.aspectRatio, baseScale, 1 };
-
-    switch (resource->header.misc.scaleAnimDir) {
-    case SPLScaleAnimDir::XY:
-        scale.x *= animScale;
-        scale.y *= animScale;
-        break;
-    case SPLScaleAnimDir::X:
-        scale.x *= animScale;
-        break;
-    case SPLScaleAnimDir::Y:
-        scale.y *= animScale;
-        break;
-    }
-
-    const auto particlePos = getWorldPosition();
-    const auto viewAxis = glm::normalize(params.pos - particlePos);
-
-    auto orientation = glm::mat4(1);
-    orientation[0] = glm::vec4(params.right, 0);
-    orientation[1] = glm::vec4(params.up, 0);
-    orientation[2] = glm::vec4(viewAxis, 0);
-
-    const auto transform = glm::translate(glm::mat4(1), particlePos)
-        * orientation
-        * glm::rotate(glm::mat4(1), rotation, { 0, 0, 1 })
-        * glm::scale(glm::mat4(1), scale);
-
-    renderer->submit(texture, {
-        .color = { color, visibility.baseAlpha * visibility.animAlpha },
-        .transform = transform,
-        .texCoords = {
-            { 0, t },
-            { s, t },
-            { s, 0 },
-            { 0, 0 }
+#include "particle_system.h"
+#include "spl_archive.h"
+
+#include <algorithm>
+
+
+
+void SPLParticleBlock::copy(u32 dst, const SPLParticleBlock& src, u32 srcIndex) {
+    position[dst] = src.position[srcIndex];
+    prevPosition[dst] = src.prevPosition[srcIndex];
+    velocity[dst] = src.velocity[srcIndex];
+    rotation[dst] = src.rotation[srcIndex];
+    prevRotation[dst] = src.prevRotation[srcIndex];
+    angularVelocity[dst] = src.angularVelocity[srcIndex];
+    lifeTime[dst] = src.lifeTime[srcIndex];
+    age[dst] = src.age[srcIndex];
+    emissionTimer[dst] = src.emissionTimer[srcIndex];
+    baseAlpha[dst] = src.baseAlpha[srcIndex];
+    animAlpha[dst] = src.animAlpha[srcIndex];
+    baseScale[dst] = src.baseScale[srcIndex];
+    animScale[dst] = src.animScale[srcIndex];
+    color[dst] = src.color[srcIndex];
+    emitterPos[dst] = src.emitterPos[srcIndex];
+    lifeTimeFactor[dst] = src.lifeTimeFactor[srcIndex];
+    texture[dst] = src.texture[srcIndex];
+    lifeRateOffset[dst] = src.lifeRateOffset[srcIndex];
+}
+
+u16 SPLParticleBlock::computeRateFactor(f32 duration) {
+    // Same representation the hardware uses: 255 * 256 / duration in frames
+    const f32 frames = std::max(duration * SPLArchive::SPL_FRAMES_PER_SECOND, 1.0f);
+    return (u16)(255.0f * 256.0f / frames);
+}
+
+u8 SPLParticleBlock::getLifeRate(u32 index) const {
+    const u64 rate = (u64)(age[index] * SPLArchive::SPL_FRAMES_PER_SECOND * lifeTimeFactor[index]) >> 8;
+    return (u8)std::min<u64>(rate, 255);
+}
+
+u8 SPLParticleBlock::getLoopRate(u32 index, u16 loopTimeFactor) const {
+    const u64 rate = (u64)(age[index] * SPLArchive::SPL_FRAMES_PER_SECOND * loopTimeFactor) >> 8;
+    return (u8)((rate + (u64)(lifeRateOffset[index] * 255.0f)) % 255);
+}
+
+glm::vec3 SPLParticleBlock::getWorldPosition(u32 index) const {
+    return emitterPos[index] + position[index];
+}
+
+glm::vec3 SPLParticleBlock::getWorldPosition(u32 index, f32 interpolation) const {
+    return emitterPos[index] + glm::mix(prevPosition[index], position[index], interpolation);
+}
+
+SPLParticleList::~SPLParticleList() {
+    clear();
+}
+
+SPLParticleList::SPLParticleList(SPLParticleList&& other) noexcept
+    : m_system(other.m_system)
+    , m_blocks(std::move(other.m_blocks))
+    , m_size(std::exchange(other.m_size, 0))
+    , m_orderBreak(std::exchange(other.m_orderBreak, ORDERED)) {
+    other.m_blocks.clear();
+}
+
+SPLParticleList& SPLParticleList::operator=(SPLParticleList&& other) noexcept {
+    if (this != &other) {
+        clear();
+
+        m_system = other.m_system;
+        m_blocks = std::move(other.m_blocks);
+        m_size = std::exchange(other.m_size, 0);
+        m_orderBreak = std::exchange(other.m_orderBreak, ORDERED);
+        other.m_blocks.clear();
+    }
+
+    return *this;
+}
+
+SPLParticleBlock* SPLParticleList::allocate(u32& index) {
+    if (!m_system->allocateParticle()) {
+        return nullptr;
+    }
+
+    if (m_blocks.empty() || m_blocks.back()->count == SPLParticleBlock::CAPACITY) {
+        const auto block = m_system->allocateBlock();
+        if (!block) {
+            m_system->freeParticles(1);
+            return nullptr;
+        }
+
+        block->count = 0;
+        m_blocks.push_back(block);
+    }
+
+    const auto block = m_blocks.back();
+    index = block->count++;
+    ++m_size;
+
+    return block;
+}
+
+u32 SPLParticleList::append(u32 count) {
+    count = m_system->allocateParticles(count);
+
+    u32 added = 0;
+    while (added < count) {
+        if (m_blocks.empty() || m_blocks.back()->count == SPLParticleBlock::CAPACITY) {
+            const auto block = m_system->allocateBlock();
+            if (!block) {
+                m_system->freeParticles(count - added);
+                break;
+            }
+
+            block->count = 0;
+            m_blocks.push_back(block);
         }
-    });
+
+        const auto block = m_blocks.back();
+        const u32 n = std::min(SPLParticleBlock::CAPACITY - block->count, count - added);
+        block->count += n;
+        added += n;
+    }
+
+    m_size += added;
+    return added;
+}
+
+void SPLParticleList::truncate(u32 size) {
+    if (size >= m_size) {
+        return;
+    }
+
+    if (size == 0) {
+        clear();
+        return;
+    }
+
+    const auto last = locate(size - 1);
+    for (size_t i = last.block + 1; i < m_blocks.size(); ++i) {
+        m_system->freeBlock(m_blocks[i]);
+    }
+
+    m_blocks.resize(last.block + 1);
+    m_blocks.back()->count = last.index + 1;
+
+    m_system->freeParticles(m_size - size);
+    m_size = size;
+
+    if (m_orderBreak >= size) {
+        m_orderBreak = ORDERED;
+    }
 }
 
-void SPLParticle::renderDirectionalBillboard(ParticleRenderer* renderer, const CameraParams& params, f32 s, f32 t) const {
-    const SPLResource* resource = emitter->getResource();
-    glm::vec3 scale = { baseScale * resource->header.aspectRatio, baseScale, 1 };
+void SPLParticleList::clear() {
+    m_system->freeParticles(m_size);
+    for (const auto block : m_blocks) {
+        m_system->freeBlock(block);
+    }
 
-    switch (resource->header.misc.scaleAnimDir) {
-    case SPLScaleAnimDir::XY:
-        scale.x *= animScale;
-        scale.y *= animScale;
-        break;
-    case SPLScaleAnimDir::X:
-        scale.x *= animScale;
-        break;
-    case SPLScaleAnimDir::Y:
-        scale.y *= animScale;
-        break;
+    m_blocks.clear();
+    m_size = 0;
+    m_orderBreak = ORDERED;
+}
+
+void SPLParticleList::retireFront(u32 count) {
+    if (count == 0) {
+        return;
     }
 
-    glm::vec3 dir = glm::cross(velocity, params.forward);
-    if (glm::length2(dir) < 0.0001f) {
+    if (count >= m_size) {
+        clear();
         return;
     }
-    
-    dir = glm::normalize(dir);
-    const auto velDir = glm::normalize(velocity);
-
-    f32 dot = glm::dot(velDir, -params.forward);
-    if (dot < 0.0f) { // Particle is behind the camera
-        dot = -dot;
-    }
-
-    scale.y *= (1.0f - dot) * resource->header.misc.dbbScale + 1.0f;
-    const auto pos = glm::vec4(getWorldPosition(), 1) * params.view;
-    const auto transform = glm::mat4(
-        dir.x * scale.x, dir.y * scale.x, 0, 0,
-        -dir.y * scale.y, dir.x * scale.y, 0, 0,
-        0, 0, 1, 0,
-        pos.x, pos.y, pos.z, 1
-    );
-
-    renderer->submit(texture, {
-        .color = { color, visibility.baseAlpha * visibility.animAlpha },
-        .transform = transform,
-        .texCoords = {
-            { 0, 0 },
-            { s, 0 },
-            { s, t },
-            { 0, t }
+
+    const auto first = locate(count);
+    for (u32 i = 0; i < first.block; ++i) {
+        m_system->freeBlock(m_blocks[i]);
+    }
+
+    m_blocks.erase(m_blocks.begin(), m_blocks.begin() + first.block);
+
+    // The rest of the first block moves to its start, leaving the free slots at its end
+    const auto block = m_blocks.front();
+    if (first.index > 0) {
+        for (u32 i = first.index; i < block->count; ++i) {
+            block->copy(i - first.index, *block, i);
+        }
+
+        block->count -= first.index;
+    }
+
+    m_system->freeParticles(count);
+    m_size -= count;
+
+    // Only the first pair of particles around the break can be gone, later breaks have to be looked for again
+    if (m_orderBreak != ORDERED) {
+        if (m_orderBreak > count) {
+            m_orderBreak -= count;
+        } else {
+            m_orderBreak = ORDERED;
+            checkExpiryOrder(1);
+        }
+    }
+}
+
+void SPLParticleList::checkExpiryOrder(u32 first) {
+    if (m_orderBreak != ORDERED || first >= m_size) {
+        return;
+    }
+
+    f32 lastLifeTime = 0.0f;
+    if (first > 0) {
+        const auto location = locate(first - 1);
+        lastLifeTime = m_blocks[location.block]->lifeTime[location.index];
+    }
+
+    for (u32 position = first; position < m_size; ++position) {
+        const auto location = locate(position);
+        const f32 lifeTime = m_blocks[location.block]->lifeTime[location.index];
+        if (lifeTime < lastLifeTime) {
+            m_orderBreak = position;
+            return;
         }
-    });
+
+        lastLifeTime = lifeTime;
+    }
+}
+
+SPLParticleList::Location SPLParticleList::locate(u32 position) const {
+    const u32 front = m_blocks.empty() ? 0 : m_blocks.front()->count;
+    const u32 slot = position < front ? position : position + getFrontGap();
+    return { slot / SPLParticleBlock::CAPACITY, slot % SPLParticleBlock::CAPACITY };
+}
+
+u32 SPLParticleList::getBlockStart(u32 block) const {
+    return block == 0 ? 0 : block * SPLParticleBlock::CAPACITY - getFrontGap();
+}
+
+u32 SPLParticleList::getFrontGap() const {
+    return m_blocks.size() > 1 ? SPLParticleBlock::CAPACITY - m_blocks.front()->count : 0;
+}
+
+void SPLParticleList::save(std::vector<SPLParticleBlock>& blocks) const {
+    blocks.resize(m_blocks.size());
+    for (size_t i = 0; i < m_blocks.size(); ++i) {
+        blocks[i] = *m_blocks[i];
+    }
+}
+
+void SPLParticleList::restore(std::span<const SPLParticleBlock> blocks) {
+    clear();
+
+    // Stops at the first block that doesn't fit completely, only the last block may be partially filled then
+    for (const auto& saved : blocks) {
+        const u32 count = m_system->allocateParticles(saved.count);
+        if (count == 0) {
+            break;
+        }
+
+        const auto block = m_system->allocateBlock();
+        if (!block) {
+            m_system->freeParticles(count);
+            break;
+        }
+
+        for (u32 i = 0; i < count; ++i) {
+            block->copy(i, saved, i);
+        }
+
+        block->count = count;
+        m_blocks.push_back(block);
+        m_size += count;
+
+        if (count < saved.count) {
+            break;
+        }
+    }
+
+    checkExpiryOrder(0);
 }
@@ -4,49 +4,191 @@
 
 #include <glm/glm.hpp>
 
-class ParticleRenderer;
-class SPLEmitter;
-struct CameraParams;
+#include <span>
+#include <utility>
+#include <vector>
 
-class SPLParticle {
-public:
-    void render(ParticleRenderer* renderer, const CameraParams& params, f32 s, f32 t) const;
-    glm::vec3 getWorldPosition() const;
+class ParticleSystem;
 
-private:
-    void renderBillboard(ParticleRenderer* renderer, const CameraParams& params, f32 s, f32 t) const;
-    void renderDirectionalBillboard(ParticleRenderer* renderer, const CameraParams& params, f32 s, f32 t) const;
+// A fixed-size chunk of particles, stored as a structure of arrays.
+// Every field lives in its own contiguous stream, so the update and render loops
+// only pull the data they actually touch through the cache.
+struct SPLParticleBlock {
+    static constexpr u32 CAPACITY = 64;
 
-public:
-    SPLEmitter* emitter; // The emitter that spawned this particle
-
-    glm::vec3 position; // position of the particle, relative to the emitter
-    glm::vec3 velocity;
-    f32 rotation;
-    f32 angularVelocity;
-    f32 lifeTime; // time the particle will live for, in seconds
-    f32 age; // time the particle has been alive for, in seconds
-    f32 emissionTimer; // time since this particle has emitted child particles, in seconds
-
-    // These two values are essentially 1.0f / lifeTime (or 1.0f / loopTime), represented as an integer
-    // They are used to map between age/lifeTime and a [0, 255] range
+    u32 count; // Number of live particles in this block
+    u32 next; // Index of the next free block while this block sits in the pool's free list
+
+    // Every stream is a multiple of 32 bytes long, so aligning the first one aligns all of them for the SIMD kernels
+    alignas(32) glm::vec3 position[CAPACITY]; // position of the particle, relative to the emitter
+    glm::vec3 prevPosition[CAPACITY]; // position at the start of the last simulation step, for render interpolation
+    glm::vec3 velocity[CAPACITY];
+    f32 rotation[CAPACITY];
+    f32 prevRotation[CAPACITY];
+    f32 angularVelocity[CAPACITY];
+    f32 lifeTime[CAPACITY]; // time the particle will live for, in seconds
+    f32 age[CAPACITY]; // time the particle has been alive for, in seconds
+    f32 emissionTimer[CAPACITY]; // time since this particle has emitted child particles, in seconds
+
+    f32 baseAlpha[CAPACITY];
+    f32 animAlpha[CAPACITY];
+    f32 baseScale[CAPACITY];
+    f32 animScale[CAPACITY];
+    glm::vec3 color[CAPACITY];
+    glm::vec3 emitterPos[CAPACITY];
+
+    // Essentially 1.0f / lifeTime, represented as an integer
+    // Used to map between age/lifeTime and a [0, 255] range
     // Mainly just to lower the amount of divisions needed in the update functions
-    u16 loopTimeFactor;
-    u16 lifeTimeFactor;
+    u16 lifeTimeFactor[CAPACITY];
 
-    u8 texture; // Index of the current texture in the resource
+    u8 texture[CAPACITY]; // Index of the current texture in the resource
 
     // A value between 0 and 1 that is added to the life rate of the particle.
     // This is used only for looping particles, so particles spawned at the same time
     // don't have aren't all in sync (animation-wise)
-    f32 lifeRateOffset;
-
-    struct {
-        f32 baseAlpha;
-        f32 animAlpha;
-    } visibility;
-    f32 baseScale;
-    f32 animScale;
-    glm::vec3 color;
-    glm::vec3 emitterPos;
+    f32 lifeRateOffset[CAPACITY];
+
+    void copy(u32 dst, const SPLParticleBlock& src, u32 srcIndex);
+
+    // Computes the value stored in lifeTimeFactor for a duration in seconds
+    static u16 computeRateFactor(f32 duration);
+
+    // Life rate of a particle mapped to [0, 255], for looking up animation tables.
+    // The loop time is shared by all particles of a resource and may be edited while they live,
+    // so its factor is passed in instead of being stored per particle.
+    u8 getLifeRate(u32 index) const;
+    u8 getLoopRate(u32 index, u16 loopTimeFactor) const;
+
+    // Remembers the current state as the start of a new simulation step
+    void beginStep(u32 index) {
+        prevPosition[index] = position[index];
+        prevRotation[index] = rotation[index];
+    }
+
+    glm::vec3 getWorldPosition(u32 index) const;
+
+    // `interpolation` blends between the state at the start (0) and the end (1) of the last simulation step
+    glm::vec3 getWorldPosition(u32 index, f32 interpolation) const;
+};
+
+// An ordered list of particles owned by an emitter.
+// Particles are packed densely into blocks taken from the particle system's pool. Every block except the first
+// and the last one is always full, the first one has its free slots at the end after losing particles at the front.
+class SPLParticleList {
+public:
+    // Where a particle at some position in the list lives
+    struct Location {
+        u32 block; // index into getBlocks()
+        u32 index; // index within the block
+    };
+
+    // Compacts a list in place while it is being iterated.
+    // Surviving particles are moved towards the front of the list in their original order,
+    // so retiring any number of particles costs a single pass over the list from the first one retired.
+    class Compactor {
+    public:
+        // Particles before position `first` all survive and aren't visited
+        explicit Compactor(SPLParticleList& list, u32 first = 0) : m_list(list), m_write(first) {
+            if (list.m_orderBreak < first) {
+                m_orderBreak = list.m_orderBreak; // Lies in the untouched part and stays where it is
+            } else if (first > 0) {
+                const auto location = list.locate(first - 1);
+                m_lastLifeTime = list.m_blocks[location.block]->lifeTime[location.index];
+            }
+        }
+
+        // Keeps the particle at the given location. Must be called in iteration order.
+        void keep(const SPLParticleBlock& block, u32 index) {
+            const auto location = m_list.locate(m_write);
+            const auto dst = m_list.m_blocks[location.block];
+            if (dst != &block || location.index != index) {
+                dst->copy(location.index, block, index);
+            }
+
+            // Once the particles that broke the expiry order have died, the list is ordered again
+            if (m_orderBreak == ORDERED && block.lifeTime[index] < m_lastLifeTime) {
+                m_orderBreak = m_write;
+            }
+
+            m_lastLifeTime = block.lifeTime[index];
+            ++m_write;
+        }
+
+        // Drops every particle that wasn't kept
+        void finish() {
+            m_list.truncate(m_write);
+            m_list.m_orderBreak = m_orderBreak;
+        }
+
+    private:
+        SPLParticleList& m_list;
+        u32 m_write;
+        f32 m_lastLifeTime = 0.0f;
+        u32 m_orderBreak = ORDERED;
+    };
+
+    explicit SPLParticleList(ParticleSystem* system) : m_system(system) {}
+    ~SPLParticleList();
+
+    SPLParticleList(const SPLParticleList&) = delete;
+    SPLParticleList& operator=(const SPLParticleList&) = delete;
+
+    // Moving transfers the blocks, the moved-from list is left empty
+    SPLParticleList(SPLParticleList&& other) noexcept;
+    SPLParticleList& operator=(SPLParticleList&& other) noexcept;
+
+    // Appends a new particle to the end of the list.
+    // Returns the block the particle lives in and writes its index within the block to `index`,
+    // or nullptr if the particle system is out of particles.
+    SPLParticleBlock* allocate(u32& index);
+
+    // Appends up to `count` uninitialized particles in one go, reserving the budget for all of them at once.
+    // Returns how many were added, they occupy the last positions of the list.
+    u32 append(u32 count);
+
+    // Shrinks the list to the first `size` particles, returning the rest to the particle system
+    void truncate(u32 size);
+    void clear();
+
+    // Removes the first `count` particles. Whole blocks go straight back to the pool and only the survivors
+    // of the new first block move, so expiring particles from the front costs O(count) regardless of the list size.
+    void retireFront(u32 count);
+
+    // True while the life times of the particles never decrease along the list. Particles in a list all age at
+    // the same rate and are appended in spawn order, so then they expire front to back, unless killed early.
+    bool isExpiryOrdered() const { return m_orderBreak == ORDERED; }
+
+    // Checks the particles from position `first` on, which must have their life time set, against the order
+    void checkExpiryOrder(u32 first);
+
+    Location locate(u32 position) const;
+
+    // Position in the list of the first particle in a block
+    u32 getBlockStart(u32 block) const;
+
+    // Copies the particles out of the pool into `blocks`, reusing its storage
+    void save(std::vector<SPLParticleBlock>& blocks) const;
+
+    // Replaces the particles with ones previously saved, as far as the particle budget allows.
+    // The blocks are filled exactly as they were saved, so the list is split into the same chunks as before.
+    void restore(std::span<const SPLParticleBlock> blocks);
+
+    u32 size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+    std::span<SPLParticleBlock* const> getBlocks() const { return m_blocks; }
+
+private:
+    static constexpr u32 ORDERED = ~0u;
+
+    // Free slots at the end of the first block that are followed by more blocks
+    u32 getFrontGap() const;
+
+private:
+    ParticleSystem* m_system;
+    std::vector<SPLParticleBlock*> m_blocks;
+    u32 m_size = 0;
+    u32 m_orderBreak = ORDERED; // Position of the first particle that dies before the one in front of it
+
 };
@@ -2,29 +2,140 @@
 #include "types.h"
 #include "util/crc32.h"
 
-#include <random>
 #include <memory>
+#include <random>
+#include <span>
 
 #include <glm/glm.hpp>
 
 class SPLRandom {
 public:
+    // An independent random stream (xoshiro256**).
+    // Every emitter owns one, so its particles can be simulated on any thread
+    // and still produce the same results regardless of how emitters are scheduled.
+    class Generator {
+    public:
+        // Generators with the same seed but different stream indices produce unrelated sequences
+        explicit Generator(u64 seed, u64 stream = 0) {
+            u64 state = seed ^ (stream * 0xD1B54A32D192ED03ull);
+            for (auto& s : m_state) {
+                s = splitMix64(state);
+            }
+        }
+
+        u64 nextU64() {
+            const u64 result = rotl(m_state[1] * 5, 7) * 9;
+            const u64 t = m_state[1] << 17;
+
+            m_state[2] ^= m_state[0];
+            m_state[3] ^= m_state[1];
+            m_state[1] ^= m_state[2];
+            m_state[0] ^= m_state[3];
+            m_state[2] ^= t;
+            m_state[3] = rotl(m_state[3], 45);
+
+            return result;
+        }
+
+        u32 nextU32() {
+            return (u32)(nextU64() >> 32);
+        }
+
+        // Uniform in [0, 1)
+        f32 nextF32() {
+            return toF32(nextU64() >> 40);
+        }
+
+        // Fills `out` with uniform floats in [0, 1), two per generator step
+        void fill(std::span<f32> out) {
+            size_t i = 0;
+            for (; i + 1 < out.size(); i += 2) {
+                const u64 bits = nextU64();
+                out[i] = toF32(bits >> 40);
+                out[i + 1] = toF32((bits >> 8) & 0xFFFFFF);
+            }
+
+            if (i < out.size()) {
+                out[i] = nextF32();
+            }
+        }
+
+    private:
+        static constexpr u64 rotl(u64 x, int k) {
+            return (x << k) | (x >> (64 - k));
+        }
+
+        static constexpr u64 splitMix64(u64& state) {
+            u64 z = (state += 0x9E3779B97F4A7C15ull);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            return z ^ (z >> 31);
+        }
+
+        // Maps 24 random bits to [0, 1)
+        static constexpr f32 toF32(u64 bits) {
+            return (f32)bits * 0x1.0p-24f;
+        }
+
+    private:
+        u64 m_state[4];
+    };
+
+    // Routes all random numbers generated on the current thread to `generator` while in scope
+    class Scope {
+    public:
+        explicit Scope(Generator& generator) : m_previous(s_current) {
+            s_current = &generator;
+        }
+
+        ~Scope() {
+            s_current = m_previous;
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        Generator* m_previous;
+    };
+
     static u64 nextU64() {
-        return getInstance()->dist();
+        return getGenerator().nextU64();
     }
 
     static u32 nextU32() {
-        return getInstance()->dist32();
+        return getGenerator().nextU32();
     }
 
     static f32 nextF32() {
-        return getInstance()->distf();
+        return getGenerator().nextF32();
     }
 
     static f32 nextF32N() {
         return nextF32() * 2.0f - 1.0f;
     }
 
+    // Fills `out` with uniform floats in [0, 1)
+    static void fill(std::span<f32> out) {
+        getGenerator().fill(out);
+    }
+
+    // Fills `out` with uniform floats in [-1, 1)
+    static void fillN(std::span<f32> out) {
+        getGenerator().fill(out);
+        for (auto& value : out) {
+            value = value * 2.0f - 1.0f;
+        }
+    }
+
+    // Fills `out` with uniform floats in [min, max)
+    static void fillRange(std::span<f32> out, f32 min, f32 max) {
+        getGenerator().fill(out);
+        for (auto& value : out) {
+            value = min + value * (max - min);
+        }
+    }
+
     static glm::vec3 unitVector() {
         return glm::normalize(glm::vec3(nextF32N(), nextF32N(), nextF32N()));
     }
@@ -35,7 +146,7 @@ public:
 
     static u32 crcHash() {
         const auto inst = getInstance();
-        const auto value = nextU64();
+        const auto value = inst->m_generator.nextU64();
         const auto hash = detail::crc::crc32_impl((const char*)&value, sizeof(value), inst->m_crcSeed);
         inst->m_crcSeed = hash; // Update seed for next call
 
@@ -74,7 +185,7 @@ public:
     SPLRandom& operator=(SPLRandom&&) = delete;
 
 private:
-    SPLRandom() : m_gen(m_rd()), m_distf(0.0f, 1.0f) {}
+    SPLRandom() : m_generator(std::random_device()()) {}
 
     static SPLRandom* getInstance() {
         if (!s_instance) {
@@ -84,26 +195,14 @@ private:
         return s_instance;
     }
 
-    u64 dist() {
-        return m_dist(m_gen);
-    }
-
-    u32 dist32() {
-        return m_dist32(m_gen);
-    }
-
-    f32 distf() {
-        return m_distf(m_gen);
+    static Generator& getGenerator() {
+        return s_current ? *s_current : getInstance()->m_generator;
     }
 
 private:
     static inline SPLRandom* s_instance;
+    static inline thread_local Generator* s_current = nullptr;
 
-    std::random_device m_rd;
-    std::mt19937_64 m_gen;
-    std::uniform_int_distribution<u64> m_dist;
-    std::uniform_int_distribution<u32> m_dist32;
-    std::uniform_real_distribution<f32> m_distf;
+    Generator m_generator; // Used outside of any Scope, only from the main thread
     u32 m_crcSeed = ~0; // Initial seed for CRC hash generation
 };
-
@@ -30,6 +30,24 @@ SPLResource SPLResource::duplicate() const {
     return res;
 }
 
+void SPLResource::bakeAnimations() {
+    if (scaleAnim) {
+        scaleAnim->bake();
+    }
+
+    if (colorAnim) {
+        colorAnim->bake(header.color);
+    }
+
+    if (alphaAnim) {
+        alphaAnim->bake();
+    }
+
+    if (texAnim) {
+        texAnim->bake();
+    }
+}
+
 SPLResource SPLResource::create() {
     SPLResource res{};
     std::memset(&res.header, 0, sizeof(res.header));
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <memory>
 #include <optional>
 #include <span>
@@ -11,10 +12,37 @@
 #include "spl_behavior.h"
 #include "types.h"
 #include "fx.h"
-#include "gfx/gl_texture.h"
+
+class GLTexture; // GPU copy of a texture, only created when rendering
 
  
 
+struct PixelA3I5 {
+    u8 color : 5;
+    u8 alpha : 3;
+
+    u8 getAlpha() const {
+        return (alpha << 5) | (alpha << 2) | (alpha >> 1);
+    }
+
+    void setAlpha(u8 a) {
+        alpha = (a >> 5) & 0x7;
+    }
+};
+
+struct PixelA5I3 {
+    u8 color : 3;
+    u8 alpha : 5;
+
+    u8 getAlpha() const {
+        return (alpha << 3) | (alpha >> 2);
+    }
+
+    void setAlpha(u8 a) {
+        alpha = (a >> 3) & 0x1F;
+    }
+};
+
 struct SPLFileHeader {
     u32 magic;
     u32 version;
@@ -336,7 +364,11 @@ struct SPLResourceHeader {
 
 struct SPLResource;
 struct SPLAnim {
-    virtual void apply(SPLParticle& ptcl, const SPLResource& resource, f32 lifeRate) const = 0;
+    // Animations are baked into tables indexed by the particle's life rate, mapped to [0, 255]
+    static constexpr u32 TABLE_SIZE = 256;
+
+    virtual ~SPLAnim() = default;
+    virtual void apply(SPLParticleBlock& block, u32 index, u8 lifeRate) const = 0;
 };
 
 struct SPLScaleAnimNative {
@@ -368,8 +400,12 @@ struct SPLScaleAnim final : SPLAnim {
         flags.loop = native.flags.loop;
     }
 
-    void apply(SPLParticle& ptcl, const SPLResource& resource, f32 lifeRate) const override;
+    std::array<f32, TABLE_SIZE> table{};
+
+    void apply(SPLParticleBlock& block, u32 index, u8 lifeRate) const override;
     void plot(std::span<f32> xs, std::span<f32> ys) const;
+    f32 evaluate(f32 lifeRate) const;
+    void bake();
 
     static SPLScaleAnim createDefault() {
         return SPLScaleAnim(SPLScaleAnimNative{
@@ -417,8 +453,12 @@ struct SPLColorAnim final : SPLAnim {
     SPLColorAnim(const glm::vec3& start, const glm::vec3& end, const SPLCurveInPeakOut& curve, decltype(flags) flags)
         : start(start), end(end), curve(curve), flags(flags) {}
 
-    void apply(SPLParticle& ptcl, const SPLResource& resource, f32 lifeRate) const override;
+    std::array<glm::vec3, TABLE_SIZE> table{};
+
+    void apply(SPLParticleBlock& block, u32 index, u8 lifeRate) const override;
     void plot(const SPLResource& resource, std::span<f32> xs, std::span<glm::vec3> ys) const;
+    glm::vec3 evaluate(const glm::vec3& peakColor, f32 lifeRate) const;
+    void bake(const glm::vec3& peakColor); // The peak color is the resource's base color
 
     static SPLColorAnim createDefault() {
         return SPLColorAnim(
@@ -473,8 +513,12 @@ struct SPLAlphaAnim final : SPLAnim {
     SPLAlphaAnim(const glm::vec3& alpha, const SPLCurveInOut& curve, decltype(flags) flags)
         : alpha({ alpha.r, alpha.g, alpha.b }), curve(curve), flags(flags) {}
 
-    void apply(SPLParticle& ptcl, const SPLResource& resource, f32 lifeRate) const override;
+    std::array<f32, TABLE_SIZE> table{}; // Unclamped and without the random range, both are applied per particle
+
+    void apply(SPLParticleBlock& block, u32 index, u8 lifeRate) const override;
     void plot(std::span<f32> xs, std::span<f32> ys) const;
+    f32 evaluate(f32 lifeRate) const;
+    void bake();
 
     static SPLAlphaAnim createDefault() {
         return SPLAlphaAnim(
@@ -518,6 +562,7 @@ struct SPLTexAnim final : SPLAnim {
     void addTexture(u8 texture = 0) {
         if (param.textureCount < MAX_TEXTURES) {
             textures[param.textureCount++] = texture;
+            bake();
         }
     }
 
@@ -525,10 +570,14 @@ struct SPLTexAnim final : SPLAnim {
         if (index < param.textureCount) {
             param.textureCount--;
             std::memmove(textures + index, textures + index + 1, (param.textureCount - index) * sizeof(u8));
+            bake();
         }
     }
 
-    void apply(SPLParticle& ptcl, const SPLResource& resource, f32 lifeRate) const override;
+    std::array<u8, TABLE_SIZE> table{};
+
+    void apply(SPLParticleBlock& block, u32 index, u8 lifeRate) const override;
+    void bake();
 
     static SPLTexAnim createDefault() {
         return SPLTexAnim(SPLTexAnimNative{
@@ -580,8 +629,8 @@ struct SPLChildResource {
         bool dpolFaceEmitter; // If set, the polygon will face the emitter
     } misc;
 
-    void applyScaleAnim(SPLParticle& ptcl, f32 lifeRate) const;
-    void applyAlphaAnim(SPLParticle& ptcl, f32 lifeRate) const;
+    void applyScaleAnim(SPLParticleBlock& block, u32 index, f32 lifeRate) const;
+    void applyAlphaAnim(SPLParticleBlock& block, u32 index, f32 lifeRate) const;
 };
 
 union SPLTextureParamNative {
@@ -704,10 +753,10 @@ struct SPLResource {
     std::optional<SPLChildResource> childResource;
     std::vector<std::shared_ptr<SPLBehavior>> behaviors;
 
-    void addScaleAnim(const SPLScaleAnim& anim) { scaleAnim = anim; header.addScaleAnim(); }
-    void addColorAnim(const SPLColorAnim& anim) { colorAnim = anim; header.addColorAnim(); }
-    void addAlphaAnim(const SPLAlphaAnim& anim) { alphaAnim = anim; header.addAlphaAnim(); }
-    void addTexAnim(const SPLTexAnim& anim) { texAnim = anim; header.addTexAnim(); }
+    void addScaleAnim(const SPLScaleAnim& anim) { scaleAnim = anim; scaleAnim->bake(); header.addScaleAnim(); }
+    void addColorAnim(const SPLColorAnim& anim) { colorAnim = anim; colorAnim->bake(header.color); header.addColorAnim(); }
+    void addAlphaAnim(const SPLAlphaAnim& anim) { alphaAnim = anim; alphaAnim->bake(); header.addAlphaAnim(); }
+    void addTexAnim(const SPLTexAnim& anim) { texAnim = anim; texAnim->bake(); header.addTexAnim(); }
 
     void removeScaleAnim() { scaleAnim.reset(); header.removeScaleAnim(); }
     void removeColorAnim() { colorAnim.reset(); header.removeColorAnim(); }
@@ -729,6 +778,9 @@ struct SPLResource {
         return getBehavior(type) != nullptr;
     }
 
+    // Rebuilds the animation tables, must be called whenever the animations or the header color change
+    void bakeAnimations();
+
     SPLResource duplicate() const;
 
     static SPLResource create();
@@ -0,0 +1,612 @@
+#include "spl_shape.h"
+#include "spl_integrate.h"
+#include "spl_random.h"
+#include "spl_simd.h"
+#include "fx.h"
+
+#include <glm/gtc/constants.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+
+namespace {
+
+// Scratch streams for one batch, every sampler works on flat arrays of random numbers
+struct Batch {
+    alignas(32) f32 x[SPLShapeSampler::MAX_BATCH];
+    alignas(32) f32 y[SPLShapeSampler::MAX_BATCH];
+    alignas(32) f32 z[SPLShapeSampler::MAX_BATCH];
+    alignas(32) f32 w[SPLShapeSampler::MAX_BATCH];
+};
+
+// Maps the batch into the emitter: position = x * axis1 + y * axis2 + z * up.
+// With `fold` set, points on the far side of the plane normal to `foldAxis` are mirrored through the origin.
+struct Frame {
+    glm::vec3 axis1;
+    glm::vec3 axis2;
+    glm::vec3 up;
+    glm::vec3 foldAxis;
+    bool fold;
+};
+
+// Minimax polynomials for sine and cosine on [-pi/4, pi/4], from Cephes' sinf and cosf
+constexpr f32 SIN_C1 = -1.6666654611e-1f;
+constexpr f32 SIN_C2 = 8.3321608736e-3f;
+constexpr f32 SIN_C3 = -1.9515295891e-4f;
+constexpr f32 COS_C1 = 4.166664568298827e-2f;
+constexpr f32 COS_C2 = -1.388731625493765e-3f;
+constexpr f32 COS_C3 = 2.443315711809948e-5f;
+
+// First guess for cube roots, a third of the exponent through the float bits (Kahan's constant)
+constexpr s32 CBRT_MAGIC = 709958130;
+constexpr u32 CBRT_ITERATIONS = 3;
+
+// The kernels below exist once per SPLSimdLevel. The vector kernels evaluate exactly the same operations in the
+// same order as the scalar ones, which also handle their tails, so the sampled positions don't depend on the CPU.
+// That rules out libm, so sine, cosine and cube roots are computed by hand.
+
+// Cosine and sine of the angles 2pi * (u - 0.5) for u in [0, 1).
+// The turn is split into the closest multiple of a quarter turn, which is exact, and a remainder of at most pi/4.
+void sinCosScalar(const f32* u, f32* cosines, f32* sines, u32 begin, u32 end) {
+    for (u32 i = begin; i < end; ++i) {
+        const f32 turn = u[i] - 0.5f;
+        const f32 quadrant = std::nearbyint(turn * 4.0f);
+        const f32 r = (turn - quadrant * 0.25f) * glm::two_pi<f32>();
+        const f32 r2 = r * r;
+
+        const f32 s = r + r * r2 * (SIN_C1 + r2 * (SIN_C2 + r2 * SIN_C3));
+        const f32 c = 1.0f - 0.5f * r2 + r2 * r2 * (COS_C1 + r2 * (COS_C2 + r2 * COS_C3));
+
+        // Rotates (c, s) by the quadrant, which is one of -2, -1, 0, 1 and 2
+        const bool odd = quadrant == 1.0f || quadrant == -1.0f;
+        const bool half = quadrant == 2.0f || quadrant == -2.0f;
+        const f32 rc = odd ? s : c;
+        const f32 rs = odd ? c : s;
+        cosines[i] = half || quadrant == 1.0f ? -rc : rc;
+        sines[i] = half || quadrant == -1.0f ? -rs : rs;
+    }
+}
+
+// Distance from the axis of points on a disk (sqrt(u)) or on a sphere at height z (sqrt(1 - z^2))
+void sqrtRadiiScalar(const f32* values, f32* radii, u32 begin, u32 end, bool sphere) {
+    for (u32 i = begin; i < end; ++i) {
+        const f32 value = sphere ? 1.0f - values[i] * values[i] : values[i];
+        radii[i] = std::sqrt(value);
+    }
+}
+
+// Cube roots of [0, 1), in place
+void cubeRootsScalar(f32* values, u32 begin, u32 end) {
+    for (u32 i = begin; i < end; ++i) {
+        const f32 x = values[i];
+        const s32 bits = (s32)((f32)std::bit_cast<s32>(x) * (1.0f / 3.0f)) + CBRT_MAGIC;
+
+        f32 y = std::bit_cast<f32>(bits);
+        for (u32 k = 0; k < CBRT_ITERATIONS; ++k) {
+            y = (y + y + x / (y * y)) * (1.0f / 3.0f);
+        }
+
+        values[i] = y;
+    }
+}
+
+void scaleScalar(Batch& batch, const f32* radii, u32 begin, u32 end, bool scaleZ) {
+    for (u32 i = begin; i < end; ++i) {
+        batch.x[i] *= radii[i];
+        batch.y[i] *= radii[i];
+        if (scaleZ) {
+            batch.z[i] *= radii[i];
+        }
+    }
+}
+
+void transformScalar(const Batch& batch, glm::vec3* positions, u32 begin, u32 end, const Frame& frame) {
+    for (u32 i = begin; i < end; ++i) {
+        glm::vec3 position;
+        position.x = batch.x[i] * frame.axis1.x + batch.y[i] * frame.axis2.x + batch.z[i] * frame.up.x;
+        position.y = batch.x[i] * frame.axis1.y + batch.y[i] * frame.axis2.y + batch.z[i] * frame.up.y;
+        position.z = batch.x[i] * frame.axis1.z + batch.y[i] * frame.axis2.z + batch.z[i] * frame.up.z;
+
+        if (frame.fold) {
+            const f32 side = position.x * frame.foldAxis.x + position.y * frame.foldAxis.y + position.z * frame.foldAxis.z;
+            position = side <= 0.0f ? -position : position;
+        }
+
+        positions[i] = position;
+    }
+}
+
+#if SPL_X64
+
+// Writes 4 points given as separate x, y and z registers as 12 interleaved floats
+SPL_TARGET("sse4.1")
+void storePoints(f32* out, __m128 x, __m128 y, __m128 z) {
+    const __m128 xy0 = _mm_unpacklo_ps(x, y); // x0 y0 x1 y1
+    const __m128 xy1 = _mm_unpackhi_ps(x, y); // x2 y2 x3 y3
+    const __m128 yz0 = _mm_unpacklo_ps(y, z); // y0 z0 y1 z1
+    const __m128 yz1 = _mm_unpackhi_ps(y, z); // y2 z2 y3 z3
+    const __m128 zx0 = _mm_unpacklo_ps(z, x); // z0 x0 z1 x1
+    const __m128 zx1 = _mm_unpackhi_ps(z, x); // z2 x2 z3 x3
+
+    _mm_storeu_ps(out, _mm_shuffle_ps(xy0, zx0, _MM_SHUFFLE(3, 0, 1, 0))); // x0 y0 z0 x1
+    _mm_storeu_ps(out + 4, _mm_shuffle_ps(yz0, xy1, _MM_SHUFFLE(1, 0, 3, 2))); // y1 z1 x2 y2
+    _mm_storeu_ps(out + 8, _mm_shuffle_ps(zx1, yz1, _MM_SHUFFLE(3, 2, 3, 0))); // z2 x3 y3 z3
+}
+
+// x * a + y * b + z * c, in the order transformScalar adds them up
+SPL_TARGET("sse4.1")
+__m128 combine(__m128 x, __m128 y, __m128 z, f32 a, f32 b, f32 c) {
+    return _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(a)), _mm_mul_ps(y, _mm_set1_ps(b))), _mm_mul_ps(z, _mm_set1_ps(c)));
+}
+
+SPL_TARGET("sse4.1")
+void sinCosSSE41(const f32* u, f32* cosines, f32* sines, u32 count) {
+    constexpr u32 LANES = 4;
+    const u32 vectorCount = count / LANES * LANES;
+
+    const __m128 signBit = _mm_set1_ps(-0.0f);
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 minusOne = _mm_set1_ps(-1.0f);
+    const __m128 two = _mm_set1_ps(2.0f);
+    const __m128 minusTwo = _mm_set1_ps(-2.0f);
+
+    for (u32 i = 0; i < vectorCount; i += LANES) {
+        const __m128 turn = _mm_sub_ps(_mm_loadu_ps(u + i), _mm_set1_ps(0.5f));
+        const __m128 quadrant = _mm_round_ps(_mm_mul_ps(turn, _mm_set1_ps(4.0f)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        const __m128 r = _mm_mul_ps(_mm_sub_ps(turn, _mm_mul_ps(quadrant, _mm_set1_ps(0.25f))), _mm_set1_ps(glm::two_pi<f32>()));
+        const __m128 r2 = _mm_mul_ps(r, r);
+
+        __m128 sp = _mm_add_ps(_mm_set1_ps(SIN_C2), _mm_mul_ps(r2, _mm_set1_ps(SIN_C3)));
+        sp = _mm_add_ps(_mm_set1_ps(SIN_C1), _mm_mul_ps(r2, sp));
+        const __m128 s = _mm_add_ps(r, _mm_mul_ps(_mm_mul_ps(r, r2), sp));
+
+        __m128 cp = _mm_add_ps(_mm_set1_ps(COS_C2), _mm_mul_ps(r2, _mm_set1_ps(COS_C3)));
+        cp = _mm_add_ps(_mm_set1_ps(COS_C1), _mm_mul_ps(r2, cp));
+        const __m128 c = _mm_add_ps(_mm_sub_ps(one, _mm_mul_ps(_mm_set1_ps(0.5f), r2)), _mm_mul_ps(_mm_mul_ps(r2, r2), cp));
+
+        const __m128 isOne = _mm_cmpeq_ps(quadrant, one);
+        const __m128 isMinusOne = _mm_cmpeq_ps(quadrant, minusOne);
+        const __m128 half = _mm_or_ps(_mm_cmpeq_ps(quadrant, two), _mm_cmpeq_ps(quadrant, minusTwo));
+        const __m128 odd = _mm_or_ps(isOne, isMinusOne);
+
+        const __m128 rc = _mm_blendv_ps(c, s, odd);
+        const __m128 rs = _mm_blendv_ps(s, c, odd);
+        _mm_storeu_ps(cosines + i, _mm_xor_ps(rc, _mm_and_ps(_mm_or_ps(half, isOne), signBit)));
+        _mm_storeu_ps(sines + i, _mm_xor_ps(rs, _mm_and_ps(_mm_or_ps(half, isMinusOne), signBit)));
+    }
+
+    sinCosScalar(u, cosines, sines, vectorCount, count);
+}
+
+SPL_TARGET("sse4.1")
+void sqrtRadiiSSE41(const f32* values, f32* radii, u32 count, bool sphere) {
+    constexpr u32 LANES = 4;
+    const u32 vectorCount = count / LANES * LANES;
+
+    for (u32 i = 0; i < vectorCount; i += LANES) {
+        __m128 value = _mm_loadu_ps(values + i);
+        if (sphere) {
+            value = _mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(value, value));
+        }
+
+        _mm_storeu_ps(radii + i, _mm_sqrt_ps(value));
+    }
+
+    sqrtRadiiScalar(values, radii, vectorCount, count, sphere);
+}
+
+SPL_TARGET("sse4.1")
+void cubeRootsSSE41(f32* values, u32 count) {
+    constexpr u32 LANES = 4;
+    const u32 vectorCount = count / LANES * LANES;
+
+    const __m128 third = _mm_set1_ps(1.0f / 3.0f);
+
+    for (u32 i = 0; i < vectorCount; i += LANES) {
+        const __m128 x = _mm_loadu_ps(values + i);
+        const __m128i bits = _mm_add_epi32(
+            _mm_cvttps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(_mm_castps_si128(x)), third)),
+            _mm_set1_epi32(CBRT_MAGIC)
+        );
+
+        __m128 y = _mm_castsi128_ps(bits);
+        for (u32 k = 0; k < CBRT_ITERATIONS; ++k) {
+            y = _mm_mul_ps(_mm_add_ps(_mm_add_ps(y, y), _mm_div_ps(x, _mm_mul_ps(y, y))), third);
+        }
+
+        _mm_storeu_ps(values + i, y);
+    }
+
+    cubeRootsScalar(values, vectorCount, count);
+}
+
+SPL_TARGET("sse4.1")
+void scaleSSE41(Batch& batch, const f32* radii, u32 count, bool scaleZ) {
+    constexpr u32 LANES = 4;
+    const u32 vectorCount = count / LANES * LANES;
+
+    for (u32 i = 0; i < vectorCount; i += LANES) {
+        const __m128 r = _mm_loadu_ps(radii + i);
+        _mm_storeu_ps(batch.x + i, _mm_mul_ps(_mm_loadu_ps(batch.x + i), r));
+        _mm_storeu_ps(batch.y + i, _mm_mul_ps(_mm_loadu_ps(batch.y + i), r));
+        if (scaleZ) {
+            _mm_storeu_ps(batch.z + i, _mm_mul_ps(_mm_loadu_ps(batch.z + i), r));
+        }
+    }
+
+    scaleScalar(batch, radii, vectorCount, count, scaleZ);
+}
+
+SPL_TARGET("sse4.1")
+void transformSSE41(const Batch& batch, glm::vec3* positions, u32 count, const Frame& frame) {
+    constexpr u32 LANES = 4;
+    const u32 vectorCount = count / LANES * LANES;
+
+    const __m128 signBit = _mm_set1_ps(-0.0f);
+
+    f32* out = &positions->x;
+    for (u32 i = 0; i < vectorCount; i += LANES) {
+        const __m128 x = _mm_loadu_ps(batch.x + i);
+        const __m128 y = _mm_loadu_ps(batch.y + i);
+        const __m128 z = _mm_loadu_ps(batch.z + i);
+
+        __m128 px = combine(x, y, z, frame.axis1.x, frame.axis2.x, frame.up.x);
+        __m128 py = combine(x, y, z, frame.axis1.y, frame.axis2.y, frame.up.y);
+        __m128 pz = combine(x, y, z, frame.axis1.z, frame.axis2.z, frame.up.z);
+
+        if (frame.fold) {
+            const __m128 side = combine(px, py, pz, frame.foldAxis.x, frame.foldAxis.y, frame.foldAxis.z);
+            const __m128 sign = _mm_and_ps(_mm_cmple_ps(side, _mm_setzero_ps()), signBit);
+            px = _mm_xor_ps(px, sign);
+            py = _mm_xor_ps(py, sign);
+            pz = _mm_xor_ps(pz, sign);
+        }
+
+        storePoints(out + i * 3, px, py, pz);
+    }
+
+    transformScalar(batch, positions, vectorCount, count, frame);
+}
+
+SPL_TARGET("avx2")
+__m256 combine(__m256 x, __m256 y, __m256 z, f32 a, f32 b, f32 c) {
+    return _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(a)), _mm256_mul_ps(y, _mm256_set1_ps(b))), _mm256_mul_ps(z, _mm256_set1_ps(c)));
+}
+
+SPL_TARGET("avx2")
+void sinCosAVX2(const f32* u, f32* cosines, f32* sines, u32 count) {
+    constexpr u32 LANES = 8;
+    const u32 vectorCount = count / LANES * LANES;
+
+    const __m256 signBit = _mm256_set1_ps(-0.0f);
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 minusOne = _mm256_set1_ps(-1.0f);
+    const __m256 two = _mm256_set1_ps(2.0f);
+    const __m256 minusTwo = _mm256_set1_ps(-2.0f);
+
+    for (u32 i = 0; i < vectorCount; i += LANES) {
+        const __m256 turn = _mm256_sub_ps(_mm256_loadu_ps(u + i), _mm256_set1_ps(0.5f));
+        const __m256 quadrant = _mm256_round_ps(_mm256_mul_ps(turn, _mm256_set1_ps(4.0f)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        const __m256 r = _mm256_mul_ps(_mm256_sub_ps(turn, _mm256_mul_ps(quadrant, _mm256_set1_ps(0.25f))), _mm256_set1_ps(glm::two_pi<f32>()));
+        const __m256 r2 = _mm256_mul_ps(r, r);
+
+        __m256 sp = _mm256_add_ps(_mm256_set1_ps(SIN_C2), _mm256_mul_ps(r2, _mm256_set1_ps(SIN_C3)));
+        sp = _mm256_add_ps(_mm256_set1_ps(SIN_C1), _mm256_mul_ps(r2, sp));
+        const __m256 s = _mm256_add_ps(r, _mm256_mul_ps(_mm256_mul_ps(r, r2), sp));
+
+        __m256 cp = _mm256_add_ps(_mm256_set1_ps(COS_C2), _mm256_mul_ps(r2, _mm256_set1_ps(COS_C3)));
+        cp = _mm256_add_ps(_mm256_set1_ps(COS_C1), _mm256_mul_ps(r2, cp));
+        const __m256 c = _mm256_add_ps(_mm256_sub_ps(one, _mm256_mul_ps(_mm256_set1_ps(0.5f), r2)), _mm256_mul_ps(_mm256_mul_ps(r2, r2), cp));
+
+        const __m256 isOne = _mm256_cmp_ps(quadrant, one, _CMP_EQ_OQ);
+        const __m256 isMinusOne = _mm256_cmp_ps(quadrant, minusOne, _CMP_EQ_OQ);
+        const __m256 half = _mm256_or_ps(_mm256_cmp_ps(quadrant, two, _CMP_EQ_OQ), _mm256_cmp_ps(quadrant, minusTwo, _CMP_EQ_OQ));
+        const __m256 odd = _mm256_or_ps(isOne, isMinusOne);
+
+        const __m256 rc = _mm256_blendv_ps(c, s, odd);
+        const __m256 rs = _mm256_blendv_ps(s, c, odd);
+        _mm256_storeu_ps(cosines + i, _mm256_xor_ps(rc, _mm256_and_ps(_mm256_or_ps(half, isOne), signBit)));
+        _mm256_storeu_ps(sines + i, _mm256_xor_ps(rs, _mm256_and_ps(_mm256_or_ps(half, isMinusOne), signBit)));
+    }
+
+    _mm256_zeroupper();
+
+    sinCosScalar(u, cosines, sines, vectorCount, count);
+}
+
+SPL_TARGET("avx2")
+void sqrtRadiiAVX2(const f32* values, f32* radii, u32 count, bool sphere) {
+    constexpr u32 LANES = 8;
+    const u32 vectorCount = count / LANES * LANES;
+
+    for (u32 i = 0; i < vectorCount; i += LANES) {
+        __m256 value = _mm256_loadu_ps(values + i);
+        if (sphere) {
+            value = _mm256_sub_ps(_mm256_set1_ps(1.0f), _mm256_mul_ps(value, value));
+        }
+
+        _mm256_storeu_ps(radii + i, _mm256_sqrt_ps(value));
+    }
+
+    _mm256_zeroupper();
+
+    sqrtRadiiScalar(values, radii, vectorCount, count, sphere);
+}
+
+SPL_TARGET("avx2")
+void cubeRootsAVX2(f32* values, u32 count) {
+    constexpr u32 LANES = 8;
+    const u32 vectorCount = count / LANES * LANES;
+
+    const __m256 third = _mm256_set1_ps(1.0f / 3.0f);
+
+    for (u32 i = 0; i < vectorCount; i += LANES) {
+        const __m256 x = _mm256_loadu_ps(values + i);
+        const __m256i bits = _mm256_add_epi32(
+            _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_castps_si256(x)), third)),
+            _mm256_set1_epi32(CBRT_MAGIC)
+        );
+
+        __m256 y = _mm256_castsi256_ps(bits);
+        for (u32 k = 0; k < CBRT_ITERATIONS; ++k) {
+            y = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(y, y), _mm256_div_ps(x, _mm256_mul_ps(y, y))), third);
+        }
+
+        _mm256_storeu_ps(values + i, y);
+    }
+
+    _mm256_zeroupper();
+
+    cubeRootsScalar(values, vectorCount, count);
+}
+
+SPL_TARGET("avx2")
+void scaleAVX2(Batch& batch, const f32* radii, u32 count, bool scaleZ) {
+    constexpr u32 LANES = 8;
+    const u32 vectorCount = count / LANES * LANES;
+
+    for (u32 i = 0; i < vectorCount; i += LANES) {
+        const __m256 r = _mm256_loadu_ps(radii + i);
+        _mm256_storeu_ps(batch.x + i, _mm256_mul_ps(_mm256_loadu_ps(batch.x + i), r));
+        _mm256_storeu_ps(batch.y + i, _mm256_mul_ps(_mm256_loadu_ps(batch.y + i), r));
+        if (scaleZ) {
+            _mm256_storeu_ps(batch.z + i, _mm256_mul_ps(_mm256_loadu_ps(batch.z + i), r));
+        }
+    }
+
+    _mm256_zeroupper();
+
+    scaleScalar(batch, radii, vectorCount, count, scaleZ);
+}
+
+SPL_TARGET("avx2")
+void transformAVX2(const Batch& batch, glm::vec3* positions, u32 count, const Frame& frame) {
+    constexpr u32 LANES = 8;
+    const u32 vectorCount = count / LANES * LANES;
+
+    const __m256 signBit = _mm256_set1_ps(-0.0f);
+
+    f32* out = &positions->x;
+    for (u32 i = 0; i < vectorCount; i += LANES) {
+        const __m256 x = _mm256_loadu_ps(batch.x + i);
+        const __m256 y = _mm256_loadu_ps(batch.y + i);
+        const __m256 z = _mm256_loadu_ps(batch.z + i);
+
+        __m256 px = combine(x, y, z, frame.axis1.x, frame.axis2.x, frame.up.x);
+        __m256 py = combine(x, y, z, frame.axis1.y, frame.axis2.y, frame.up.y);
+        __m256 pz = combine(x, y, z, frame.axis1.z, frame.axis2.z, frame.up.z);
+
+        if (frame.fold) {
+            const __m256 side = combine(px, py, pz, frame.foldAxis.x, frame.foldAxis.y, frame.foldAxis.z);
+            const __m256 sign = _mm256_and_ps(_mm256_cmp_ps(side, _mm256_setzero_ps(), _CMP_LE_OQ), signBit);
+            px = _mm256_xor_ps(px, sign);
+            py = _mm256_xor_ps(py, sign);
+            pz = _mm256_xor_ps(pz, sign);
+        }
+
+        // Interleaving crosses lanes, the halves are written as two groups of 4 points
+        storePoints(out + i * 3, _mm256_castps256_ps128(px), _mm256_castps256_ps128(py), _mm256_castps256_ps128(pz));
+        storePoints(out + i * 3 + 12, _mm256_extractf128_ps(px, 1), _mm256_extractf128_ps(py, 1), _mm256_extractf128_ps(pz, 1));
+    }
+
+    _mm256_zeroupper();
+
+    transformScalar(batch, positions, vectorCount, count, frame);
+}
+
+#endif
+
+void sinCos(const f32* u, f32* cosines, f32* sines, u32 count) {
+    switch (SPLIntegrator::getLevel()) {
+#if SPL_X64
+    case SPLSimdLevel::AVX2: sinCosAVX2(u, cosines, sines, count); break;
+    case SPLSimdLevel::SSE41: sinCosSSE41(u, cosines, sines, count); break;
+#endif
+    default: sinCosScalar(u, cosines, sines, 0, count); break;
+    }
+}
+
+void sqrtRadii(const f32* values, f32* radii, u32 count, bool sphere) {
+    switch (SPLIntegrator::getLevel()) {
+#if SPL_X64
+    case SPLSimdLevel::AVX2: sqrtRadiiAVX2(values, radii, count, sphere); break;
+    case SPLSimdLevel::SSE41: sqrtRadiiSSE41(values, radii, count, sphere); break;
+#endif
+    default: sqrtRadiiScalar(values, radii, 0, count, sphere); break;
+    }
+}
+
+void cubeRoots(f32* values, u32 count) {
+    switch (SPLIntegrator::getLevel()) {
+#if SPL_X64
+    case SPLSimdLevel::AVX2: cubeRootsAVX2(values, count); break;
+    case SPLSimdLevel::SSE41: cubeRootsSSE41(values, count); break;
+#endif
+    default: cubeRootsScalar(values, 0, count); break;
+    }
+}
+
+void scale(Batch& batch, const f32* radii, u32 count, bool scaleZ) {
+    switch (SPLIntegrator::getLevel()) {
+#if SPL_X64
+    case SPLSimdLevel::AVX2: scaleAVX2(batch, radii, count, scaleZ); break;
+    case SPLSimdLevel::SSE41: scaleSSE41(batch, radii, count, scaleZ); break;
+#endif
+    default: scaleScalar(batch, radii, 0, count, scaleZ); break;
+    }
+}
+
+void transform(const Batch& batch, glm::vec3* positions, u32 count, const Frame& frame) {
+    switch (SPLIntegrator::getLevel()) {
+#if SPL_X64
+    case SPLSimdLevel::AVX2: transformAVX2(batch, positions, count, frame); break;
+    case SPLSimdLevel::SSE41: transformSSE41(batch, positions, count, frame); break;
+#endif
+    default: transformScalar(batch, positions, 0, count, frame); break;
+    }
+}
+
+// Unit circle: x = cos, y = sin of a uniform angle
+void sampleCircle(Batch& batch, u32 count) {
+    SPLRandom::fill({ batch.w, count });
+    sinCos(batch.w, batch.x, batch.y, count);
+}
+
+// Unit disk, uniform over the area
+void sampleDisk(Batch& batch, u32 count) {
+    sampleCircle(batch, count);
+    SPLRandom::fill({ batch.z, count });
+
+    sqrtRadii(batch.z, batch.w, count, false);
+    scale(batch, batch.w, count, false);
+}
+
+// Unit sphere surface, uniform over the area
+void sampleSphere(Batch& batch, u32 count) {
+    SPLRandom::fillN({ batch.z, count });
+    sampleCircle(batch, count);
+
+    sqrtRadii(batch.z, batch.w, count, true);
+    scale(batch, batch.w, count, false);
+}
+
+// Unit ball, uniform over the volume
+void sampleBall(Batch& batch, u32 count) {
+    sampleSphere(batch, count);
+
+    SPLRandom::fill({ batch.w, count });
+    cubeRoots(batch.w, count);
+    scale(batch, batch.w, count, true);
+}
+
+// Heights along the emitter axis, uniform in [-length, length)
+void sampleHeights(Batch& batch, u32 count, f32 length) {
+    SPLRandom::fill({ batch.z, count });
+
+    for (u32 i = 0; i < count; ++i) {
+        batch.z[i] = (batch.z[i] * 2.0f - 1.0f) * length;
+    }
+}
+
+// Scales the batch by `radius`, unrotated
+Frame getScaledFrame(f32 radius) {
+    return {
+        .axis1 = { radius, 0.0f, 0.0f },
+        .axis2 = { 0.0f, radius, 0.0f },
+        .up = { 0.0f, 0.0f, radius },
+        .foldAxis = {},
+        .fold = false,
+    };
+}
+
+// Into the emitter frame, x/y are scaled by `radius`, z is used as is
+Frame getTiltedFrame(const SPLEmissionShape& shape, f32 radius) {
+    return {
+        .axis1 = shape.axis1 * radius,
+        .axis2 = shape.axis2 * radius,
+        .up = shape.up,
+        .foldAxis = {},
+        .fold = false,
+    };
+}
+
+// Mirrors points below the emitter plane to the upper half
+Frame getHemisphereFrame(const SPLEmissionShape& shape, f32 radius) {
+    auto frame = getScaledFrame(radius);
+    frame.foldAxis = shape.up;
+    frame.fold = true;
+    return frame;
+}
+
+}
+
+void SPLShapeSampler::sample(const SPLEmissionShape& shape, glm::vec3* positions, u32 first, u32 count, u32 total) {
+    // Shapes with a zero radius still get a tiny one, so particles have a direction to move in
+    const f32 radius = shape.radius == 0.0f ? FX32_F32_EPSILON : shape.radius;
+
+    Batch batch;
+
+    switch (shape.type) {
+    case SPLEmissionType::Point:
+        std::fill_n(positions, count, glm::vec3(0));
+        break;
+
+    case SPLEmissionType::SphereSurface:
+        sampleSphere(batch, count);
+        transform(batch, positions, count, getScaledFrame(radius));
+        break;
+
+    case SPLEmissionType::Sphere:
+        sampleBall(batch, count);
+        transform(batch, positions, count, getScaledFrame(radius));
+        break;
+
+    case SPLEmissionType::CircleBorder:
+        sampleCircle(batch, count);
+        std::fill_n(batch.z, count, 0.0f);
+        transform(batch, positions, count, getTiltedFrame(shape, radius));
+        break;
+
+    case SPLEmissionType::CircleBorderUniform:
+        // Evenly spaced around the circle, starting on the axis2 side
+        for (u32 i = 0; i < count; ++i) {
+            const f32 angle = glm::two_pi<f32>() * (f32)(first + i) / (f32)total;
+            batch.x[i] = std::sin(angle);
+            batch.y[i] = std::cos(angle);
+            batch.z[i] = 0.0f;
+        }
+
+        transform(batch, positions, count, getTiltedFrame(shape, shape.radius));
+        break;
+
+    case SPLEmissionType::Circle:
+        sampleDisk(batch, count);
+        std::fill_n(batch.z, count, 0.0f);
+        transform(batch, positions, count, getTiltedFrame(shape, radius));
+        break;
+
+    case SPLEmissionType::CylinderSurface:
+        sampleCircle(batch, count);
+        sampleHeights(batch, count, shape.length);
+        transform(batch, positions, count, getTiltedFrame(shape, radius));
+        break;
+
+    case SPLEmissionType::Cylinder:
+        sampleDisk(batch, count);
+        sampleHeights(batch, count, shape.length);
+        transform(batch, positions, count, getTiltedFrame(shape, radius));
+        break;
+
+    case SPLEmissionType::HemisphereSurface:
+        sampleSphere(batch, count);
+        transform(batch, positions, count, getHemisphereFrame(shape, radius));
+        break;
+
+    case SPLEmissionType::Hemisphere:
+        sampleBall(batch, count);
+        transform(batch, positions, count, getHemisphereFrame(shape, radius));
+        break;
+    }
+}
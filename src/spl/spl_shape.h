@@ -0,0 +1,31 @@
+#pragma once
+
+#include "spl_resource.h"
+#include "types.h"
+
+#include <glm/glm.hpp>
+
+// Everything an emission shape needs to place particles, resolved once per emission
+struct SPLEmissionShape {
+    SPLEmissionType type;
+    f32 radius;
+    f32 length;
+
+    // Orthonormal emitter frame, circles and cylinders lie in the axis1/axis2 plane and extend along up
+    glm::vec3 axis1;
+    glm::vec3 axis2;
+    glm::vec3 up;
+};
+
+// Samples particle positions for a whole emission at a time.
+// Random numbers are drawn in bulk from the current SPLRandom stream into flat arrays,
+// and every shape is computed by kernels over those arrays, picked by SPLIntegrator::getLevel().
+// The SSE4.1 and AVX2 kernels produce bit-identical positions to the scalar ones.
+class SPLShapeSampler {
+public:
+    static constexpr u32 MAX_BATCH = 64;
+
+    // Writes `count` (at most MAX_BATCH) positions relative to the emitter.
+    // `first` and `total` place the batch within the whole emission, for shapes that distribute particles evenly.
+    static void sample(const SPLEmissionShape& shape, glm::vec3* positions, u32 first, u32 count, u32 total);
+};
@@ -0,0 +1,20 @@
+#pragma once
+
+// Shared setup for the SIMD kernels. Every kernel is compiled for its instruction set through a function
+// attribute, so the rest of the program doesn't require it, and picked at runtime by SPLIntegrator::getLevel().
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define SPL_X64 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#else
+#define SPL_X64 0
+#endif
+
+#if SPL_X64 && !defined(_MSC_VER)
+#define SPL_TARGET(isa) __attribute__((target(isa)))
+#else
+#define SPL_TARGET(isa)
+#endif
@@ -1,5 +1,7 @@
 #include "spl_resource.h"
 
+#include <spdlog/spdlog.h>
+
 #include <ranges>
 
 
@@ -170,6 +172,133 @@ void convertToDirect(const u8* rgba, GXRgba* out, size_t pixelCount) {
     }
 }
 
+std::vector<u8> convertFromA3I5(const u8* tex, const GXRgba* pal, size_t width, size_t height, size_t palSize) {
+    std::vector<u8> texture(width * height * 4);
+    const auto pixels = reinterpret_cast<const PixelA3I5*>(tex);
+
+    for (size_t i = 0; i < width * height; i++) {
+        GXRgba color = pal[pixels[i].color];
+
+        texture[i * 4 + 0] = color.r8();
+        texture[i * 4 + 1] = color.g8();
+        texture[i * 4 + 2] = color.b8();
+        texture[i * 4 + 3] = pixels[i].getAlpha();
+    }
+
+    return texture;
+}
+
+std::vector<u8> convertFromPalette4(const u8* tex, const GXRgba* pal, size_t width, size_t height, size_t palSize, bool color0Transparent) {
+    std::vector<u8> texture(width * height * 4);
+    const auto pixels = tex;
+    const u8 alpha0 = color0Transparent ? 0 : 0xFF;
+
+    for (size_t i = 0; i < width * height; i += 4) {
+        const u8 pixel = pixels[i / 4];
+
+        u8 index = pixel & 0x3;
+        texture[i * 4 + 0] = pal[index].r8();
+        texture[i * 4 + 1] = pal[index].g8();
+        texture[i * 4 + 2] = pal[index].b8();
+        texture[i * 4 + 3] = index == 0 ? alpha0 : 0xFF;
+
+        index = (pixel >> 2) & 0x3;
+        texture[i * 4 + 4] = pal[index].r8();
+        texture[i * 4 + 5] = pal[index].g8();
+        texture[i * 4 + 6] = pal[index].b8();
+        texture[i * 4 + 7] = index == 0 ? alpha0 : 0xFF;
+
+        index = (pixel >> 4) & 0x3;
+        texture[i * 4 + 8] = pal[index].r8();
+        texture[i * 4 + 9] = pal[index].g8();
+        texture[i * 4 + 10] = pal[index].b8();
+        texture[i * 4 + 11] = index == 0 ? alpha0 : 0xFF;
+
+        index = (pixel >> 6) & 0x3;
+        texture[i * 4 + 12] = pal[index].r8();
+        texture[i * 4 + 13] = pal[index].g8();
+        texture[i * 4 + 14] = pal[index].b8();
+        texture[i * 4 + 15] = index == 0 ? alpha0 : 0xFF;
+    }
+
+    return texture;
+}
+
+std::vector<u8> convertFromPalette16(const u8* tex, const GXRgba* pal, size_t width, size_t height, size_t palSize, bool color0Transparent) {
+    std::vector<u8> texture(width * height * 4);
+    const auto pixels = tex;
+    const u8 alpha0 = color0Transparent ? 0 : 0xFF;
+
+    for (size_t i = 0; i < width * height; i += 2) {
+        const u8 pixel = pixels[i / 2];
+
+        u8 index = pixel & 0xF;
+        texture[i * 4 + 0] = pal[index].r8();
+        texture[i * 4 + 1] = pal[index].g8();
+        texture[i * 4 + 2] = pal[index].b8();
+        texture[i * 4 + 3] = index == 0 ? alpha0 : 0xFF;
+
+        index = (pixel >> 4) & 0xF;
+        texture[i * 4 + 4] = pal[index].r;
+        texture[i * 4 + 5] = pal[index].g;
+        texture[i * 4 + 6] = pal[index].b;
+        texture[i * 4 + 7] = index == 0 ? alpha0 : 0xFF;
+    }
+
+    return texture;
+}
+
+std::vector<u8> convertFromPalette256(const u8* tex, const GXRgba* pal, size_t width, size_t height, size_t palSize, bool color0Transparent) {
+    std::vector<u8> texture(width * height * 4);
+    const auto pixels = tex;
+    const u8 alpha0 = color0Transparent ? 0 : 0xFF;
+
+    for (size_t i = 0; i < width * height; i++) {
+        const u8 pixel = pixels[i];
+        const u8 index = pixel;
+        texture[i * 4 + 0] = pal[index].r8();
+        texture[i * 4 + 1] = pal[index].g8();
+        texture[i * 4 + 2] = pal[index].b8();
+        texture[i * 4 + 3] = index == 0 ? alpha0 : 0xFF;
+    }
+
+    return texture;
+}
+
+std::vector<u8> convertFromComp4x4(const u8* tex, const GXRgba* pal, size_t width, size_t height, size_t palSize) {
+    spdlog::warn("Comp4x4 texture conversion not implemented");
+    return {};
+}
+
+std::vector<u8> convertFromA5I3(const u8* tex, const GXRgba* pal, size_t width, size_t height, size_t palSize) {
+    std::vector<u8> texture(width * height * 4);
+    const auto pixels = reinterpret_cast<const PixelA5I3*>(tex);
+
+    for (size_t i = 0; i < width * height; i++) {
+        GXRgba color = pal[pixels[i].color];
+
+        texture[i * 4 + 0] = color.r8();
+        texture[i * 4 + 1] = color.g8();
+        texture[i * 4 + 2] = color.b8();
+        texture[i * 4 + 3] = pixels[i].getAlpha();
+    }
+
+    return texture;
+}
+
+std::vector<u8> convertFromDirect(const GXRgba* tex, size_t width, size_t height) {
+    std::vector<u8> texture(width * height * 4);
+
+    for (size_t i = 0; i < width * height; i++) {
+        texture[i * 4 + 0] = tex[i].r8();
+        texture[i * 4 + 1] = tex[i].g8();
+        texture[i * 4 + 2] = tex[i].b8();
+        texture[i * 4 + 3] = tex[i].a ? 0xFF : 0x00;
+    }
+
+    return texture;
+}
+
 }
 
 bool SPLTexture::convertFromRGBA8888(
@@ -221,3 +350,68 @@ bool SPLTexture::convertFromRGBA8888(
 
     return true;
 }
+
+std::vector<u8> SPLTexture::convertToRGBA8888() const {
+    switch ((TextureFormat)param.format) {
+    case TextureFormat::A3I5:
+        return convertFromA3I5(
+            textureData.data(),
+            (const GXRgba*)paletteData.data(),
+            width,
+            height,
+            paletteData.size()
+        );
+    case TextureFormat::Palette4:
+        return convertFromPalette4(
+            textureData.data(),
+            (const GXRgba*)paletteData.data(),
+            width,
+            height,
+            paletteData.size(),
+            param.palColor0Transparent
+        );
+    case TextureFormat::Palette16:
+        return convertFromPalette16(
+            textureData.data(),
+            (const GXRgba*)paletteData.data(),
+            width,
+            height,
+            paletteData.size(),
+            param.palColor0Transparent
+        );
+    case TextureFormat::Palette256:
+        return convertFromPalette256(
+            textureData.data(),
+            (const GXRgba*)paletteData.data(),
+            width,
+            height,
+            paletteData.size(),
+            param.palColor0Transparent
+        );
+    case TextureFormat::Comp4x4:
+        return convertFromComp4x4(
+            textureData.data(),
+            (const GXRgba*)paletteData.data(),
+            width,
+            height,
+            paletteData.size()
+        );
+    case TextureFormat::A5I3:
+        return convertFromA5I3(
+            textureData.data(),
+            (const GXRgba*)paletteData.data(),
+            width,
+            height,
+            paletteData.size()
+        );
+    case TextureFormat::Direct:
+        return convertFromDirect(
+            (const GXRgba*)textureData.data(),
+            width,
+            height
+        );
+    default:
+        spdlog::error("Unsupported texture format: {}", (int)param.format);
+        return {};
+    }
+}
@@ -202,10 +202,6 @@ size_t TextureImportSpecification::getSizeEstimate(size_t width, size_t height)
     }
 }
 
-std::vector<u8> SPLTexture::convertToRGBA8888() const {
-    return GLTexture::toRGBA(*this);
-}
-
 #define PIXEL2BPP(byte, pixel) (((byte) >> ((pixel) * 2)) & 0b11)
 #define PIXEL4BPP(byte, pixel) (((byte) >> ((pixel) * 4)) & 0b1111)
 
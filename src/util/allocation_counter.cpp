@@ -0,0 +1,69 @@
+#include "allocation_counter.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+
+namespace {
+
+std::atomic<u64> g_allocations = 0;
+
+void* allocate(std::size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(size ? size : 1);
+}
+
+// Over-aligned blocks are carved out of a larger malloc block, the original pointer is stored right before them.
+// aligned_alloc isn't available everywhere and needs sizes that are multiples of the alignment.
+void* allocateAligned(std::size_t size, std::align_val_t alignment) {
+    const auto align = (std::size_t)alignment;
+    void* block = allocate(size + align + sizeof(void*));
+    if (!block) {
+        return nullptr;
+    }
+
+    const auto address = ((std::uintptr_t)block + sizeof(void*) + align - 1) & ~(std::uintptr_t)(align - 1);
+    ((void**)address)[-1] = block;
+
+    return (void*)address;
+}
+
+void freeAligned(void* ptr) {
+    if (ptr) {
+        std::free(((void**)ptr)[-1]);
+    }
+}
+
+}
+
+u64 AllocationCounter::getCount() {
+    return g_allocations.load(std::memory_order_relaxed);
+}
+
+// The remaining forms (array, nothrow and sized) forward to these by default
+
+void* operator new(std::size_t size) {
+    if (const auto ptr = allocate(size)) {
+        return ptr;
+    }
+
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    if (const auto ptr = allocateAligned(size, alignment)) {
+        return ptr;
+    }
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept {
+    freeAligned(ptr);
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include "types.h"
+
+
+// Counts the heap allocations made through operator new by the whole program.
+// Linking allocation_counter.cpp replaces the global allocation functions, so every
+// container, string and smart pointer allocation is included, on every thread.
+class AllocationCounter {
+public:
+    // Allocations since the program started, compare two readings to count what happened in between
+    static u64 getCount();
+};
@@ -0,0 +1,51 @@
+#include "frame_arena.h"
+
+#include <algorithm>
+#include <new>
+
+
+FrameArena::FrameArena(size_t capacity)
+    : m_buffer(std::make_unique<std::byte[]>(capacity)), m_capacity(capacity) {}
+
+FrameArena::~FrameArena() {
+    for (const auto& [ptr, alignment] : m_overflow) {
+        ::operator delete(ptr, std::align_val_t(alignment));
+    }
+}
+
+void FrameArena::reset() {
+    m_lastFrameUsage = getUsed();
+
+    for (const auto& [ptr, alignment] : m_overflow) {
+        ::operator delete(ptr, std::align_val_t(alignment));
+    }
+
+    if (!m_overflow.empty()) {
+        // Room for everything the frame needed in one piece, plus slack for alignment padding and growth
+        m_capacity = std::max(m_capacity * 2, m_lastFrameUsage + m_lastFrameUsage / 2);
+        m_buffer = std::make_unique<std::byte[]>(m_capacity);
+        m_overflow.clear();
+    }
+
+    m_used = 0;
+    m_overflowBytes = 0;
+}
+
+void* FrameArena::do_allocate(size_t bytes, size_t alignment) {
+    void* ptr = m_buffer.get() + m_used;
+    size_t space = m_capacity - m_used;
+    if (std::align(alignment, bytes, ptr, space)) {
+        m_used = m_capacity - space + bytes;
+        return ptr;
+    }
+
+    ptr = ::operator new(bytes, std::align_val_t(alignment));
+    m_overflow.push_back({ ptr, alignment });
+    m_overflowBytes += bytes;
+
+    return ptr;
+}
+
+void FrameArena::do_deallocate(void*, size_t, size_t) {
+    // Memory is only released by reset
+}
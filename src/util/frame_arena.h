@@ -0,0 +1,52 @@
+#pragma once
+
+#include "types.h"
+
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+
+// Monotonic memory resource for containers that only live for a single frame.
+// Allocating bumps a pointer through one buffer, deallocating does nothing and everything is released at once by reset.
+// Whatever doesn't fit goes to the heap, and the next reset grows the buffer to the peak usage of the frame,
+// so once the workload settles frames don't touch the heap at all.
+class FrameArena final : public std::pmr::memory_resource {
+public:
+    explicit FrameArena(size_t capacity);
+    ~FrameArena() override;
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    // Releases everything allocated since the last reset. Containers using the arena must be gone by then, or at least
+    // hold no storage from it: clearing a vector keeps its capacity, which may point into a buffer reset frees.
+    void reset();
+
+    size_t getCapacity() const { return m_capacity; }
+
+    // Bytes handed out since the last reset, including what overflowed to the heap
+    size_t getUsed() const { return m_used + m_overflowBytes; }
+
+    // Bytes handed out during the last frame, before the most recent reset
+    size_t getLastFrameUsage() const { return m_lastFrameUsage; }
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void* ptr, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+    struct Overflow {
+        void* ptr;
+        size_t alignment;
+    };
+
+private:
+    std::unique_ptr<std::byte[]> m_buffer;
+    size_t m_capacity;
+    size_t m_used = 0;
+
+    std::vector<Overflow> m_overflow;
+    size_t m_overflowBytes = 0;
+    size_t m_lastFrameUsage = 0;
+};
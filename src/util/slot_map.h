@@ -0,0 +1,164 @@
+#pragma once
+
+#include "types.h"
+
+#include <span>
+#include <utility>
+#include <vector>
+
+// Densely packed storage addressed through generational handles.
+// Values live in one contiguous array in the order they were added, which removing keeps. Adding is O(1),
+// removing shifts the values after the gap down, so batch removals through eraseIf, which does it in one pass.
+// Pointers to values are only valid until the next add or remove.
+// A handle stays valid until its value is removed, after that it never resolves again, even if the slot is reused.
+template<typename T>
+class SlotMap {
+public:
+    struct Handle {
+        u32 slot = 0;
+        u32 generation = 0; // 0 is never used by a live value, so a default constructed handle is always invalid
+
+        bool operator==(const Handle&) const = default;
+    };
+
+    // Everything except the values, copying it and refilling the values in the same order recreates all handles
+    struct Layout {
+        struct Slot {
+            u32 index; // Index of the value while occupied, next free slot otherwise
+            u32 generation;
+        };
+
+        std::vector<Slot> slots;
+        std::vector<u32> denseSlots; // Slot of every value, in value order
+        u32 freeHead = INVALID;
+    };
+
+    template<typename... Args>
+    Handle emplace(Args&&... args) {
+        m_values.emplace_back(std::forward<Args>(args)...);
+
+        u32 slot;
+        if (m_layout.freeHead != INVALID) {
+            slot = m_layout.freeHead;
+            m_layout.freeHead = m_layout.slots[slot].index;
+        } else {
+            slot = (u32)m_layout.slots.size();
+            m_layout.slots.push_back({ .generation = 1 });
+        }
+
+        auto& entry = m_layout.slots[slot];
+        entry.index = (u32)m_values.size() - 1;
+        m_layout.denseSlots.push_back(slot);
+
+        return { slot, entry.generation };
+    }
+
+    bool erase(Handle handle) {
+        if (!contains(handle)) {
+            return false;
+        }
+
+        const u32 index = m_layout.slots[handle.slot].index;
+        releaseSlot(m_layout.denseSlots[index]);
+
+        m_values.erase(m_values.begin() + index);
+        m_layout.denseSlots.erase(m_layout.denseSlots.begin() + index);
+        for (u32 i = index; i < m_values.size(); ++i) {
+            m_layout.slots[m_layout.denseSlots[i]].index = i;
+        }
+
+        return true;
+    }
+
+    // Removes every value matching the predicate, compacting the rest in place in a single pass
+    template<typename Pred>
+    void eraseIf(Pred&& pred) {
+        u32 write = 0;
+        for (u32 read = 0; read < m_values.size(); ++read) {
+            if (pred(m_values[read])) {
+                releaseSlot(m_layout.denseSlots[read]);
+                continue;
+            }
+
+            if (write != read) {
+                m_values[write] = std::move(m_values[read]);
+                m_layout.denseSlots[write] = m_layout.denseSlots[read];
+                m_layout.slots[m_layout.denseSlots[write]].index = write;
+            }
+
+            ++write;
+        }
+
+        m_values.erase(m_values.begin() + write, m_values.end());
+        m_layout.denseSlots.resize(write);
+    }
+
+    void clear() {
+        // Bumping the generations keeps old handles from resolving to new values
+        for (const u32 slot : m_layout.denseSlots) {
+            releaseSlot(slot);
+        }
+
+        m_values.clear();
+        m_layout.denseSlots.clear();
+    }
+
+    bool contains(Handle handle) const {
+        return handle.slot < m_layout.slots.size()
+            && handle.generation != 0
+            && m_layout.slots[handle.slot].generation == handle.generation;
+    }
+
+    T* get(Handle handle) {
+        return contains(handle) ? &m_values[m_layout.slots[handle.slot].index] : nullptr;
+    }
+
+    const T* get(Handle handle) const {
+        return contains(handle) ? &m_values[m_layout.slots[handle.slot].index] : nullptr;
+    }
+
+    // Handle of the value at the given position in values()
+    Handle getHandle(u32 index) const {
+        const u32 slot = m_layout.denseSlots[index];
+        return { slot, m_layout.slots[slot].generation };
+    }
+
+    const Layout& getLayout() const { return m_layout; }
+
+    // Replaces the contents with `layout` and values created by make(i) for every position i,
+    // which must recreate the values in the order they had when the layout was taken
+    template<typename Fn>
+    void assign(const Layout& layout, Fn&& make) {
+        m_values.clear();
+        m_layout = layout;
+
+        m_values.reserve(m_layout.denseSlots.size());
+        for (u32 i = 0; i < m_layout.denseSlots.size(); ++i) {
+            m_values.push_back(make(i));
+        }
+    }
+
+    std::span<T> values() { return m_values; }
+    std::span<const T> values() const { return m_values; }
+
+    u32 size() const { return (u32)m_values.size(); }
+    bool empty() const { return m_values.empty(); }
+
+private:
+    static constexpr u32 INVALID = 0xFFFFFFFF;
+
+    // Invalidates the slot's handles and puts it on the free list, the value itself is left to the caller
+    void releaseSlot(u32 slot) {
+        auto& entry = m_layout.slots[slot];
+        if (++entry.generation == 0) {
+            entry.generation = 1;
+        }
+
+        entry.index = m_layout.freeHead;
+        m_layout.freeHead = slot;
+    }
+
+private:
+    std::vector<T> m_values;
+    Layout m_layout;
+};
@@ -0,0 +1,132 @@
+#include "thread_pool.h"
+
+
+ThreadPool::ThreadPool(u32 workerCount)
+    : m_queues(std::make_unique<Queue[]>(workerCount + 1)), m_queueCount(workerCount + 1) {
+    m_workers.reserve(workerCount);
+    for (u32 i = 0; i < workerCount; ++i) {
+        m_workers.emplace_back(&ThreadPool::workerMain, this, i + 1);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard lock(m_sleepMutex);
+        m_stop = true;
+    }
+
+    m_wakeup.notify_all();
+    for (auto& worker : m_workers) {
+        worker.join();
+    }
+}
+
+bool ThreadPool::push(const Task& task) {
+    // Threads that don't belong to this pool share queue 0
+    const u32 index = s_threadIndex < m_queueCount ? s_threadIndex : 0;
+    auto& queue = m_queues[index];
+
+    std::lock_guard lock(queue.mutex);
+    if (queue.size == QUEUE_CAPACITY) {
+        return false;
+    }
+
+    queue.tasks[(queue.head + queue.size) % QUEUE_CAPACITY] = task;
+    ++queue.size;
+    m_queuedTasks.fetch_add(1, std::memory_order_release);
+
+    return true;
+}
+
+bool ThreadPool::pop(u32 queueIndex, Task& task) {
+    auto& queue = m_queues[queueIndex];
+
+    std::lock_guard lock(queue.mutex);
+    if (queue.size == 0) {
+        return false;
+    }
+
+    --queue.size;
+    task = queue.tasks[(queue.head + queue.size) % QUEUE_CAPACITY];
+    m_queuedTasks.fetch_sub(1, std::memory_order_relaxed);
+
+    return true;
+}
+
+bool ThreadPool::steal(u32 queueIndex, Task& task) {
+    auto& queue = m_queues[queueIndex];
+
+    std::lock_guard lock(queue.mutex);
+    if (queue.size == 0) {
+        return false;
+    }
+
+    task = queue.tasks[queue.head];
+    queue.head = (queue.head + 1) % QUEUE_CAPACITY;
+    --queue.size;
+    m_queuedTasks.fetch_sub(1, std::memory_order_relaxed);
+
+    return true;
+}
+
+bool ThreadPool::tryGetTask(Task& task) {
+    const u32 own = s_threadIndex < m_queueCount ? s_threadIndex : 0;
+    if (pop(own, task)) {
+        return true;
+    }
+
+    for (u32 i = 1; i < m_queueCount; ++i) {
+        if (steal((own + i) % m_queueCount, task)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void ThreadPool::execute(const Task& task) {
+    task.invoke(task.context, task.begin, task.end);
+    task.pending->fetch_sub(1, std::memory_order_acq_rel);
+}
+
+void ThreadPool::wait(const std::atomic<u32>& pending) {
+    while (pending.load(std::memory_order_acquire) > 0) {
+        Task task;
+        if (tryGetTask(task)) {
+            execute(task);
+        } else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void ThreadPool::wakeWorkers() {
+    {
+        // Taking the lock orders this with a worker checking its wait condition,
+        // otherwise the notification could slip in before the worker starts waiting
+        std::lock_guard lock(m_sleepMutex);
+    }
+
+    m_wakeup.notify_all();
+}
+
+void ThreadPool::workerMain(u32 index) {
+    s_threadIndex = index;
+
+    while (true) {
+        Task task;
+        if (tryGetTask(task)) {
+            execute(task);
+            continue;
+        }
+
+        std::unique_lock lock(m_sleepMutex);
+        m_wakeup.wait(lock, [this] {
+            return m_stop || m_queuedTasks.load(std::memory_order_acquire) > 0;
+        });
+
+        if (m_stop) {
+            break;
+        }
+    }
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "types.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+
+// A small work-stealing thread pool.
+// Every thread owns a task queue. It pops its own tasks LIFO and steals from the other queues FIFO
+// once it runs dry. Threads waiting for a parallelFor help executing queued tasks instead of blocking,
+// so parallel loops can be nested freely (e.g. emitters in parallel, chunks of one emitter in parallel).
+class ThreadPool {
+public:
+    // Creates `workerCount` background threads. The thread calling parallelFor always takes part as well.
+    explicit ThreadPool(u32 workerCount);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    u32 getWorkerCount() const { return (u32)m_workers.size(); }
+
+    // Calls fn(i) for every i in [0, count), in tasks of `grain` consecutive iterations.
+    // Returns once every iteration has finished.
+    template<typename Fn>
+    void parallelFor(u32 count, u32 grain, Fn&& fn) {
+        if (count == 0) {
+            return;
+        }
+
+        using Func = std::remove_reference_t<Fn>;
+        constexpr auto invoke = [](void* context, u32 begin, u32 end) {
+            auto& func = *static_cast<Func*>(context);
+            for (u32 i = begin; i < end; ++i) {
+                func(i);
+            }
+        };
+
+        grain = std::max(grain, 1u);
+        std::atomic<u32> pending = (count + grain - 1) / grain;
+        void* context = const_cast<void*>(static_cast<const void*>(std::addressof(fn)));
+
+        for (u32 begin = 0; begin < count; begin += grain) {
+            const Task task = { invoke, context, begin, std::min(begin + grain, count), &pending };
+            if (!push(task)) {
+                execute(task); // Queue is full, just run it here
+            }
+        }
+
+        wakeWorkers();
+        wait(pending);
+    }
+
+    // Index of the calling thread: 1..N for the pool's workers, 0 for any other thread
+    static u32 getCurrentThreadIndex() { return s_threadIndex; }
+
+private:
+    struct Task {
+        void (*invoke)(void* context, u32 begin, u32 end);
+        void* context;
+        u32 begin;
+        u32 end;
+        std::atomic<u32>* pending;
+    };
+
+    static constexpr u32 QUEUE_CAPACITY = 256;
+
+    struct alignas(64) Queue {
+        std::mutex mutex;
+        std::array<Task, QUEUE_CAPACITY> tasks;
+        u32 head = 0; // Steal end
+        u32 size = 0;
+    };
+
+    bool push(const Task& task);
+    bool pop(u32 queueIndex, Task& task);
+    bool steal(u32 queueIndex, Task& task);
+    bool tryGetTask(Task& task);
+
+    void execute(const Task& task);
+    void wait(const std::atomic<u32>& pending);
+    void wakeWorkers();
+    void workerMain(u32 index);
+
+private:
+    std::vector<std::thread> m_workers;
+    std::unique_ptr<Queue[]> m_queues; // One per worker, plus one (index 0) shared by outside threads
+    u32 m_queueCount;
+
+    std::mutex m_sleepMutex;
+    std::condition_variable m_wakeup;
+    std::atomic<u32> m_queuedTasks = 0;
+    bool m_stop = false;
+
+    static inline thread_local u32 s_threadIndex = 0;
+};
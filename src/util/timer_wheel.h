@@ -0,0 +1,113 @@
+#pragma once
+
+#include "types.h"
+
+#include <algorithm>
+#include <array>
+#include <vector>
+
+// Hierarchical timer wheel over integer ticks.
+// Level 0 has a slot for each of the next 64 ticks, every further level covers 64 times the range of the previous one.
+// Timers far out sit in a coarse slot and move down a level whenever the wheel reaches it, so scheduling is O(1)
+// and advancing only ever touches timers that are due (or about to be), no matter how many are waiting.
+// Timers can't be cancelled, values should be validated when they fire instead.
+template<typename T>
+class TimerWheel {
+public:
+    static constexpr u32 SLOT_BITS = 6;
+    static constexpr u32 SLOTS = 1u << SLOT_BITS;
+    static constexpr u32 LEVELS = 4;
+
+    // Fires `value` once the wheel advances to `tick`, ticks that already passed fire on the next advance
+    void schedule(u64 tick, const T& value) {
+        insert({ std::max(tick, m_now + 1), value });
+        ++m_count;
+    }
+
+    // Moves the wheel forward to `now`, calling fire(value) for every timer that came due, in tick order.
+    // Timers scheduled from within fire are handled as well.
+    template<typename Fn>
+    void advance(u64 now, Fn&& fire) {
+        while (m_now < now) {
+            ++m_now;
+
+            // Whenever a level wraps around, the next slot of the level above comes into range
+            for (u32 level = 1; level < LEVELS; ++level) {
+                if ((m_now & ((1ull << (SLOT_BITS * level)) - 1)) != 0) {
+                    break;
+                }
+
+                cascade(m_slots[level][(m_now >> (SLOT_BITS * level)) & (SLOTS - 1)]);
+            }
+
+            auto& slot = m_slots[0][m_now & (SLOTS - 1)];
+            if (slot.empty()) {
+                continue;
+            }
+
+            m_firing.swap(slot);
+            for (const auto& timer : m_firing) {
+                if (timer.tick > m_now) {
+                    insert(timer); // Beyond the range of the wheel, keeps going around the top level
+                    continue;
+                }
+
+                --m_count;
+                fire(timer.value);
+            }
+
+            m_firing.clear();
+        }
+    }
+
+    void clear() {
+        for (auto& level : m_slots) {
+            for (auto& slot : level) {
+                slot.clear();
+            }
+        }
+
+        m_count = 0;
+    }
+
+    u64 getNow() const { return m_now; }
+    u32 size() const { return m_count; }
+
+private:
+    struct Timer {
+        u64 tick;
+        T value;
+    };
+
+    void insert(const Timer& timer) {
+        // The level is picked by the highest tick digit that differs from the current time
+        const u64 diff = timer.tick ^ m_now;
+
+        u32 level = 0;
+        while (level + 1 < LEVELS && (diff >> (SLOT_BITS * (level + 1))) != 0) {
+            ++level;
+        }
+
+        m_slots[level][(timer.tick >> (SLOT_BITS * level)) & (SLOTS - 1)].push_back(timer);
+    }
+
+    void cascade(std::vector<Timer>& slot) {
+        if (slot.empty()) {
+            return;
+        }
+
+        m_cascading.swap(slot);
+        for (const auto& timer : m_cascading) {
+            insert(timer);
+        }
+
+        m_cascading.clear();
+    }
+
+private:
+    std::array<std::array<std::vector<Timer>, SLOTS>, LEVELS> m_slots;
+    std::vector<Timer> m_firing;
+    std::vector<Timer> m_cascading;
+    u64 m_now = 0;
+    u32 m_count = 0;
+};
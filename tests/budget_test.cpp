@@ -0,0 +1,147 @@
+// Checks that the spawn bounds the budget is split by never fall below what an update actually spawns,
+// and that every budget policy hands out at most the particles left while accounting for each denied spawn.
+
+#include "check.h"
+#include "spl/particle_system.h"
+
+#include <vector>
+
+namespace {
+
+constexpr u32 STEPS = 30;
+
+// Particles outlive the test, so the change in particle count is exactly what was spawned
+SPLResource makeParent(u32 emissionCount, bool children) {
+    auto resource = SPLResource::create();
+    resource.header.emissionCount = emissionCount;
+    resource.header.emitterLifeTime = 100.0f;
+    resource.header.particleLifeTime = 100.0f;
+    resource.header.variance.lifeTime = 0.0f;
+    resource.header.misc.emissionInterval = 0.1f;
+
+    if (children) {
+        resource.header.flags.hasChildResource = true;
+        resource.childResource = SPLChildResource{};
+        resource.childResource->lifeTime = 100.0f;
+        resource.childResource->misc.emissionCount = 2;
+        resource.childResource->misc.emissionInterval = 0.1f;
+    }
+
+    return resource;
+}
+
+u32 getSize(const SPLEmitter& emitter) {
+    return emitter.getParticles().size() + emitter.getChildParticles().size();
+}
+
+struct Outcome {
+    std::vector<u32> spawned;
+    std::vector<u64> denied;
+};
+
+Outcome run(const SPLResource& resource, BudgetPolicy policy, u32 maxParticles, const std::vector<f32>& priorities) {
+    ParticleSystem system(maxParticles);
+    system.setFixedTimestep(true);
+    system.setSnapshotInterval(0);
+    system.setBudgetPolicy(policy);
+
+    std::vector<EmitterHandle> handles;
+    for (const f32 priority : priorities) {
+        handles.push_back(system.addEmitter(resource));
+        system.getEmitter(handles.back())->setPriority(priority);
+    }
+
+    for (u32 step = 0; step < STEPS; ++step) {
+        system.update(ParticleSystem::FIXED_TIMESTEP);
+        CHECK(system.getParticleCount() <= maxParticles);
+    }
+
+    Outcome outcome;
+    u64 denied = 0;
+    for (const auto handle : handles) {
+        const auto emitter = system.getEmitter(handle);
+        outcome.spawned.push_back(getSize(*emitter));
+        outcome.denied.push_back(emitter->getDeniedSpawns());
+        denied += emitter->getDeniedSpawns();
+    }
+
+    CHECK(system.getDeniedSpawns() == denied);
+    return outcome;
+}
+
+void checkBounds(const SPLResource& resource) {
+    ParticleSystem system(1000000);
+    system.setFixedTimestep(true);
+    system.setSnapshotInterval(0);
+
+    std::vector<EmitterHandle> handles;
+    for (u32 i = 0; i < 3; ++i) {
+        handles.push_back(system.addEmitter(resource));
+    }
+
+    for (u32 step = 0; step < STEPS; ++step) {
+        std::vector<u32> before, bounds;
+        for (const auto handle : handles) {
+            const auto emitter = system.getEmitter(handle);
+            before.push_back(getSize(*emitter));
+            bounds.push_back(emitter->getExactSpawnUpperBound());
+            CHECK(emitter->getExactSpawnUpperBound() <= emitter->getSpawnUpperBound());
+        }
+
+        system.update(ParticleSystem::FIXED_TIMESTEP);
+
+        for (size_t i = 0; i < handles.size(); ++i) {
+            CHECK(getSize(*system.getEmitter(handles[i])) - before[i] <= bounds[i]);
+        }
+    }
+
+    CHECK(system.getParticleCount() > 0);
+    CHECK(system.getDeniedSpawns() == 0);
+}
+
+}
+
+int main() {
+    const auto flood = makeParent(100, false);
+    const auto tree = makeParent(10, true);
+
+    checkBounds(flood);
+    checkBounds(tree);
+
+    // What every emitter asks for, when nothing is denied
+    const auto demand = run(flood, BudgetPolicy::FirstCome, 1000000, { 1.0f, 1.0f }).spawned[0];
+    CHECK(demand > 100);
+
+    // The first step alone wants more than the budget, so the policies split it up front
+    const auto firstCome = run(flood, BudgetPolicy::FirstCome, 100, { 1.0f, 1.0f });
+    const auto fair = run(flood, BudgetPolicy::Fair, 100, { 1.0f, 1.0f });
+    const auto priority = run(flood, BudgetPolicy::Priority, 100, { 3.0f, 1.0f });
+    const auto zero = run(flood, BudgetPolicy::Priority, 100, { 0.0f, 1.0f });
+
+    CHECK(firstCome.spawned[0] + firstCome.spawned[1] == 100);
+    CHECK((fair.spawned == std::vector<u32>{ 50, 50 }));
+    CHECK((priority.spawned == std::vector<u32>{ 75, 25 }));
+    CHECK((zero.spawned == std::vector<u32>{ 0, 100 }));
+
+    for (const auto& outcome : { firstCome, fair, priority, zero }) {
+        for (size_t i = 0; i < outcome.spawned.size(); ++i) {
+            CHECK(outcome.spawned[i] + outcome.denied[i] == demand);
+        }
+    }
+
+    // Children compete for the same budget as their parents, and quotas cover both
+    const auto treeDemand = run(tree, BudgetPolicy::FirstCome, 1000000, { 1.0f, 1.0f, 1.0f }).spawned[0];
+    for (const auto policy : { BudgetPolicy::FirstCome, BudgetPolicy::Fair, BudgetPolicy::Priority }) {
+        const auto outcome = run(tree, policy, treeDemand, { 4.0f, 2.0f, 1.0f });
+
+        u32 spawned = 0;
+        for (size_t i = 0; i < outcome.spawned.size(); ++i) {
+            CHECK(outcome.spawned[i] > 0);
+            spawned += outcome.spawned[i];
+        }
+
+        CHECK(spawned <= treeDemand);
+    }
+
+    return finish();
+}
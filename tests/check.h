@@ -0,0 +1,27 @@
+#pragma once
+
+#include <fmt/format.h>
+
+#include <cstdio>
+
+// Minimal assertions for the simulation tests. Every test is its own executable registered with CTest,
+// failed checks are reported and counted, and main returns the result of finish().
+
+inline int g_failedChecks = 0;
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            fmt::print(stderr, "{}:{}: check failed: {}\n", __FILE__, __LINE__, #condition); \
+            ++g_failedChecks; \
+        } \
+    } while (false)
+
+inline int finish() {
+    if (g_failedChecks > 0) {
+        fmt::print(stderr, "{} check(s) failed\n", g_failedChecks);
+        return 1;
+    }
+
+    return 0;
+}
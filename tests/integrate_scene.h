@@ -0,0 +1,53 @@
+#pragma once
+
+// Random particle blocks for exercising SPLIntegrator, shared by integrate_test and integrate_bench
+
+#include "spl/spl_integrate.h"
+#include "spl/spl_particle.h"
+
+#include <memory>
+#include <random>
+#include <span>
+#include <vector>
+
+struct IntegrateScene {
+    std::vector<std::unique_ptr<SPLParticleBlock>> blocks;
+    std::vector<glm::vec3> acceleration;
+};
+
+// One block per entry of `counts`, holding that many particles. Scenes with the same seed and counts are identical.
+inline IntegrateScene makeIntegrateScene(u32 seed, std::span<const u32> counts) {
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution dist(-1.0f, 1.0f);
+
+    IntegrateScene scene;
+    scene.acceleration.resize(SPLParticleBlock::CAPACITY);
+    for (auto& acc : scene.acceleration) {
+        acc = { dist(gen), dist(gen), dist(gen) };
+    }
+
+    for (const u32 count : counts) {
+        auto block = std::make_unique<SPLParticleBlock>();
+        block->count = count;
+        for (u32 i = 0; i < count; ++i) {
+            block->position[i] = { dist(gen), dist(gen), dist(gen) };
+            block->velocity[i] = { dist(gen), dist(gen), dist(gen) };
+            block->rotation[i] = dist(gen);
+            block->angularVelocity[i] = dist(gen);
+            block->age[i] = 0;
+            block->emissionTimer[i] = 0;
+        }
+
+        scene.blocks.push_back(std::move(block));
+    }
+
+    return scene;
+}
+
+// Integrates every block of the scene once with the current SPLIntegrator level
+inline void stepIntegrateScene(IntegrateScene& scene, f32 dt) {
+    const glm::vec3 emitterVelocity = { 0.1f, -0.2f, 0.3f };
+    for (const auto& block : scene.blocks) {
+        SPLIntegrator::integrate(*block, scene.acceleration.data(), 0.99f, emitterVelocity, dt);
+    }
+}
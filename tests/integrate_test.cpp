@@ -0,0 +1,59 @@
+// Checks that every SIMD integration kernel the CPU supports produces bit-identical results to the scalar one,
+// including the scalar tails of blocks whose size isn't a multiple of the vector width.
+
+#include "check.h"
+#include "integrate_scene.h"
+
+#include <cstring>
+#include <numeric>
+
+namespace {
+
+constexpr u32 STEPS = 50;
+
+// One block for every particle count from 1 to a full block
+IntegrateScene makeScene(u32 seed) {
+    std::vector<u32> counts(SPLParticleBlock::CAPACITY);
+    std::iota(counts.begin(), counts.end(), 1u);
+    return makeIntegrateScene(seed, counts);
+}
+
+void run(IntegrateScene& scene, SPLSimdLevel level) {
+    SPLIntegrator::setLevel(level);
+    for (u32 step = 0; step < STEPS; ++step) {
+        stepIntegrateScene(scene, 1.0f / 30.0f);
+    }
+}
+
+// Compares whole blocks, so kernels must not touch anything past the particle count either
+bool matches(const IntegrateScene& a, const IntegrateScene& b) {
+    for (size_t i = 0; i < a.blocks.size(); ++i) {
+        if (std::memcmp(a.blocks[i].get(), b.blocks[i].get(), sizeof(SPLParticleBlock)) != 0) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+}
+
+int main() {
+    auto reference = makeScene(1);
+    run(reference, SPLSimdLevel::Scalar);
+
+    const auto supported = SPLIntegrator::getSupportedLevel();
+    for (const auto level : { SPLSimdLevel::SSE41, SPLSimdLevel::AVX2 }) {
+        if (level > supported) {
+            fmt::print("Kernel {} is not supported by this CPU, skipped\n", SPLIntegrator::getLevelName(level));
+            continue;
+        }
+
+        auto scene = makeScene(1);
+        run(scene, level);
+        CHECK(SPLIntegrator::getLevel() == level);
+        CHECK(matches(reference, scene));
+    }
+
+    return finish();
+}
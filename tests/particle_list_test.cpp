@@ -0,0 +1,275 @@
+// Checks that SPLParticleList keeps its particles packed in order as they are compacted,
+// retired from the front, and tracks whether their life times still expire front to back.
+
+#include "check.h"
+#include "spl/particle_system.h"
+
+#include <functional>
+#include <vector>
+
+namespace {
+
+constexpr u32 MAX_PARTICLES = 10000;
+
+// Every particle carries an id in its age, so the order of the list can be followed
+void append(SPLParticleList& list, u32 count, u32 firstId, const std::function<f32(u32)>& lifeTime) {
+    const u32 first = list.size();
+    CHECK(list.append(count) == count);
+
+    for (u32 i = 0; i < count; ++i) {
+        const auto location = list.locate(first + i);
+        const auto block = list.getBlocks()[location.block];
+        block->age[location.index] = (f32)(firstId + i);
+        block->lifeTime[location.index] = lifeTime(firstId + i);
+    }
+
+    list.checkExpiryOrder(first);
+}
+
+std::vector<u32> getIds(const SPLParticleList& list) {
+    std::vector<u32> ids;
+    for (const auto block : list.getBlocks()) {
+        for (u32 i = 0; i < block->count; ++i) {
+            ids.push_back((u32)block->age[i]);
+        }
+    }
+
+    return ids;
+}
+
+// Only the first and the last block may be partially filled, and positions map onto the blocks both ways
+void checkLayout(const SPLParticleList& list) {
+    const auto blocks = list.getBlocks();
+
+    u32 size = 0;
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        CHECK(blocks[i]->count > 0);
+        CHECK(blocks[i]->count == SPLParticleBlock::CAPACITY || i == 0 || i == blocks.size() - 1);
+        CHECK(list.getBlockStart((u32)i) == size);
+
+        for (u32 j = 0; j < blocks[i]->count; ++j) {
+            const auto location = list.locate(size + j);
+            CHECK(location.block == i && location.index == j);
+        }
+
+        size += blocks[i]->count;
+    }
+
+    CHECK(size == list.size());
+}
+
+std::vector<u32> getRange(u32 first, u32 last) {
+    std::vector<u32> ids;
+    for (u32 id = first; id < last; ++id) {
+        ids.push_back(id);
+    }
+
+    return ids;
+}
+
+// Visits the particles from position `first` on, like SPLEmitter does from the first dead one
+template<class Fn>
+void compact(SPLParticleList& list, Fn keep, u32 first = 0) {
+    SPLParticleList::Compactor compactor(list, first);
+    const auto blocks = list.getBlocks();
+    const auto start = list.locate(first);
+    for (size_t b = start.block; b < blocks.size(); ++b) {
+        for (u32 i = b == start.block ? start.index : 0; i < blocks[b]->count; ++i) {
+            if (keep((u32)blocks[b]->age[i])) {
+                compactor.keep(*blocks[b], i);
+            }
+        }
+    }
+
+    compactor.finish();
+}
+
+}
+
+int main() {
+    ParticleSystem system(MAX_PARTICLES);
+    const auto byId = [](u32 id) { return (f32)id; };
+
+    // Compaction keeps the survivors in order and returns everything past them
+    {
+        SPLParticleList list(&system);
+        append(list, 300, 0, byId);
+        CHECK(list.getBlocks().size() == 5);
+        CHECK(list.isExpiryOrdered());
+
+        compact(list, [](u32 id) { return id % 3 != 0; });
+
+        std::vector<u32> expected;
+        for (u32 id = 0; id < 300; ++id) {
+            if (id % 3 != 0) {
+                expected.push_back(id);
+            }
+        }
+
+        CHECK(getIds(list) == expected);
+        CHECK(list.size() == 200);
+        CHECK(list.getBlocks().size() == 4);
+        CHECK(system.getParticleCount() == 200);
+        CHECK(list.isExpiryOrdered());
+        checkLayout(list);
+
+        compact(list, [](u32) { return true; });
+        CHECK(getIds(list) == expected);
+        checkLayout(list);
+
+        compact(list, [](u32) { return false; });
+        CHECK(list.empty());
+        CHECK(list.getBlocks().empty());
+        CHECK(system.getParticleCount() == 0);
+    }
+
+    // Particles that outlive those spawned after them break the order until they are compacted out
+    {
+        SPLParticleList list(&system);
+        append(list, 100, 0, byId);
+        append(list, 10, 1000, [](u32 id) { return (f32)(id - 1000) + 0.5f; });
+        CHECK(!list.isExpiryOrdered());
+
+        append(list, 10, 2000, byId);
+        compact(list, [](u32 id) { return id < 1000 || id >= 2000; });
+        CHECK(list.isExpiryOrdered());
+        CHECK(list.size() == 110);
+        checkLayout(list);
+
+        // Equal life times are still in order
+        append(list, 5, 2010, [](u32) { return 2009.0f; });
+        CHECK(list.isExpiryOrdered());
+
+        list.clear();
+        CHECK(system.getParticleCount() == 0);
+    }
+
+    // Compacting from a later position leaves the particles in front alone, the order is only
+    // recovered once the particles that broke it are gone
+    {
+        const auto early = [](u32 id) { return (f32)(id % 1000) + 0.5f; };
+        SPLParticleList list(&system);
+        append(list, 100, 0, byId);
+        append(list, 10, 1000, early);
+        append(list, 100, 2000, byId);
+        CHECK(!list.isExpiryOrdered());
+
+        compact(list, [](u32 id) { return id < 2000 || id % 2 == 0; }, 110);
+        CHECK(list.size() == 160);
+        CHECK(!list.isExpiryOrdered());
+        checkLayout(list);
+
+        std::vector<u32> expected = getRange(0, 100);
+        for (const auto& range : { getRange(1000, 1010), getRange(2000, 2100) }) {
+            for (const u32 id : range) {
+                if (id < 2000 || id % 2 == 0) {
+                    expected.push_back(id);
+                }
+            }
+        }
+
+        CHECK(getIds(list) == expected);
+
+        compact(list, [](u32 id) { return id < 1000 || id >= 1005; }, 100);
+        CHECK(!list.isExpiryOrdered());
+        compact(list, [](u32 id) { return id < 1000 || id >= 2000; }, 100);
+        CHECK(list.isExpiryOrdered());
+        CHECK(list.size() == 150);
+        checkLayout(list);
+
+        // A break behind the start of the compaction is found again
+        append(list, 10, 1000, early);
+        CHECK(!list.isExpiryOrdered());
+        compact(list, [](u32) { return true; }, 140);
+        CHECK(!list.isExpiryOrdered());
+        compact(list, [](u32 id) { return id < 1000 || id >= 2000; }, 150);
+        CHECK(list.isExpiryOrdered());
+
+        // Retiring the particles around the break looks for the next one
+        append(list, 10, 1000, early);
+        append(list, 10, 3000, byId);
+        append(list, 10, 1200, early);
+        list.retireFront(100);
+        CHECK(!list.isExpiryOrdered());
+        list.retireFront(50);
+        CHECK(!list.isExpiryOrdered());
+        list.retireFront(20);
+        CHECK(list.isExpiryOrdered());
+        CHECK(getIds(list) == getRange(1200, 1210));
+
+        list.clear();
+        CHECK(system.getParticleCount() == 0);
+    }
+
+    // Retiring from the front frees whole blocks and leaves a gap in the first one, which the rest of the list
+    // works around until that block is gone as well
+    {
+        SPLParticleList list(&system);
+        append(list, 200, 0, byId);
+
+        list.retireFront(70);
+        CHECK(getIds(list) == getRange(70, 200));
+        CHECK(list.getBlocks().size() == 3);
+        CHECK(list.getBlocks()[0]->count == 58);
+        CHECK(system.getParticleCount() == 130);
+        CHECK(list.isExpiryOrdered());
+        checkLayout(list);
+
+        // New particles fill the last block, not the gap
+        append(list, 100, 200, byId);
+        CHECK(getIds(list) == getRange(70, 300));
+        CHECK(list.getBlocks()[0]->count == 58);
+        CHECK(list.isExpiryOrdered());
+        checkLayout(list);
+
+        // Exactly the first block
+        list.retireFront(58);
+        CHECK(getIds(list) == getRange(128, 300));
+        CHECK(list.getBlocks()[0]->count == SPLParticleBlock::CAPACITY);
+        checkLayout(list);
+
+        // Within the first block, then compacting and truncating across the gap
+        list.retireFront(1);
+        list.retireFront(10);
+        CHECK(getIds(list) == getRange(139, 300));
+        checkLayout(list);
+
+        compact(list, [](u32 id) { return id % 2 == 0; });
+        CHECK(getIds(list).front() == 140);
+        CHECK(list.size() == 80);
+        CHECK(list.isExpiryOrdered());
+        checkLayout(list);
+
+        list.truncate(60);
+        CHECK(getIds(list).back() == 258);
+        checkLayout(list);
+
+        list.retireFront(0);
+        CHECK(list.size() == 60);
+
+        list.retireFront(1000);
+        CHECK(list.empty());
+        CHECK(list.getBlocks().empty());
+        CHECK(list.isExpiryOrdered());
+        CHECK(system.getParticleCount() == 0);
+    }
+
+    // The budget limits how many particles a list takes
+    {
+        SPLParticleList list(&system);
+        CHECK(list.append(MAX_PARTICLES + 100) == MAX_PARTICLES);
+        CHECK(list.size() == MAX_PARTICLES);
+
+        u32 index;
+        CHECK(list.allocate(index) == nullptr);
+
+        list.truncate(10);
+        CHECK(list.size() == 10);
+        CHECK(list.getBlocks().size() == 1);
+        CHECK(system.getParticleCount() == 10);
+    }
+
+    CHECK(system.getParticleCount() == 0);
+
+    return finish();
+}
@@ -0,0 +1,89 @@
+// Checks that SlotMap handles resolve exactly as long as their value lives, generations keep stale handles
+// from resolving to values that reuse the slot, and values stay in insertion order as others are removed.
+
+#include "check.h"
+#include "util/slot_map.h"
+
+#include <memory>
+#include <vector>
+
+namespace {
+
+using Map = SlotMap<std::unique_ptr<int>>;
+
+std::vector<int> getValues(const Map& map) {
+    std::vector<int> values;
+    for (const auto& value : map.values()) {
+        values.push_back(*value);
+    }
+
+    return values;
+}
+
+}
+
+int main() {
+    Map map;
+    CHECK(map.get(Map::Handle{}) == nullptr);
+
+    std::vector<Map::Handle> handles;
+    for (int i = 0; i < 8; ++i) {
+        handles.push_back(map.emplace(std::make_unique<int>(i)));
+    }
+
+    for (int i = 0; i < 8; ++i) {
+        CHECK(map.get(handles[i]) && **map.get(handles[i]) == i);
+        CHECK(map.getHandle(i) == handles[i]);
+    }
+
+    // Removing keeps the order of the rest, and the handles of the rest keep resolving
+    CHECK(map.erase(handles[2]));
+    CHECK(!map.erase(handles[2]));
+    map.eraseIf([](const std::unique_ptr<int>& value) { return *value % 3 == 0; });
+    CHECK((getValues(map) == std::vector{ 1, 4, 5, 7 }));
+
+    for (int i = 0; i < 8; ++i) {
+        const bool alive = i != 2 && i % 3 != 0;
+        CHECK((map.get(handles[i]) != nullptr) == alive);
+        if (alive) {
+            CHECK(**map.get(handles[i]) == i);
+        }
+    }
+
+    for (u32 i = 0; i < map.size(); ++i) {
+        CHECK(**map.get(map.getHandle(i)) == getValues(map)[i]);
+    }
+
+    // New values reuse the freed slots with a new generation and go to the end
+    const auto reused = map.emplace(std::make_unique<int>(100));
+    CHECK(reused.slot == handles[0].slot || reused.slot == handles[2].slot
+        || reused.slot == handles[3].slot || reused.slot == handles[6].slot);
+    CHECK(reused.generation > 1);
+    CHECK((getValues(map) == std::vector{ 1, 4, 5, 7, 100 }));
+    for (const int dead : { 0, 2, 3, 6 }) {
+        CHECK(map.get(handles[dead]) == nullptr);
+    }
+
+    // A layout and the values in order recreate every handle
+    const auto layout = map.getLayout();
+    const auto values = getValues(map);
+
+    Map copy;
+    copy.assign(layout, [&](u32 i) { return std::make_unique<int>(values[i]); });
+    CHECK(getValues(copy) == values);
+    CHECK(copy.get(reused) && **copy.get(reused) == 100);
+    CHECK(copy.get(handles[4]) && **copy.get(handles[4]) == 4);
+    CHECK(copy.get(handles[3]) == nullptr);
+
+    // Clearing invalidates everything, also for values added afterwards
+    map.clear();
+    CHECK(map.empty());
+    CHECK(map.get(reused) == nullptr);
+    CHECK(map.get(handles[1]) == nullptr);
+
+    const auto fresh = map.emplace(std::make_unique<int>(7));
+    CHECK(map.get(handles[7]) == nullptr);
+    CHECK(map.get(fresh) && **map.get(fresh) == 7);
+
+    return finish();
+}
@@ -0,0 +1,96 @@
+// Checks that TimerWheel fires every timer exactly on its tick, across all levels and past the range of
+// the top level, however far the wheel advances at once, and also timers scheduled while firing.
+
+#include "check.h"
+#include "util/timer_wheel.h"
+
+#include <random>
+#include <vector>
+
+namespace {
+
+struct Fired {
+    u32 id;
+    u64 tick; // Wheel time it fired at
+};
+
+}
+
+int main() {
+    constexpr u64 TOP_RANGE = 1ull << (TimerWheel<u32>::SLOT_BITS * TimerWheel<u32>::LEVELS);
+
+    TimerWheel<u32> wheel;
+    std::vector<u64> due;
+    std::vector<Fired> fired;
+
+    const auto schedule = [&](u64 tick) {
+        wheel.schedule(tick, (u32)due.size());
+        due.push_back(tick);
+    };
+
+    // Ticks on every level, on level boundaries, and beyond the top level
+    std::mt19937_64 gen(1);
+    for (u32 level = 0; level < TimerWheel<u32>::LEVELS; ++level) {
+        const u64 range = 1ull << (TimerWheel<u32>::SLOT_BITS * (level + 1));
+        for (u32 i = 0; i < 50; ++i) {
+            schedule(1 + gen() % range);
+        }
+
+        schedule(range);
+        schedule(range - 1);
+        schedule(range + 1);
+    }
+
+    schedule(TOP_RANGE * 2 + 3);
+    CHECK(wheel.size() == due.size());
+
+    // Each timer fired early schedules a follow-up, which has to fire on time as well
+    const auto fire = [&](u32 id) {
+        fired.push_back({ id, wheel.getNow() });
+        if (id % 7 == 0 && due[id] < TOP_RANGE) {
+            schedule(due[id] + 1 + id % 100);
+        }
+    };
+
+    // Irregular strides, a few of them larger than a whole level
+    u64 now = 0;
+    while (now < TOP_RANGE * 2 + 10) {
+        now += 1 + gen() % (now < 5000 ? 7 : 300000);
+        wheel.advance(now, fire);
+        CHECK(wheel.getNow() == now);
+    }
+
+    CHECK(wheel.size() == 0);
+    CHECK(fired.size() == due.size());
+
+    std::vector<u32> fireCount(due.size(), 0);
+    u64 last = 0;
+    for (const auto& [id, tick] : fired) {
+        CHECK(tick == due[id]);
+        CHECK(tick >= last);
+        last = tick;
+        ++fireCount[id];
+    }
+
+    for (const u32 count : fireCount) {
+        CHECK(count == 1);
+    }
+
+    // Ticks that already passed fire on the next step, clear drops everything
+    wheel.schedule(1, 1000);
+    wheel.schedule(wheel.getNow() + 100, 1001);
+    CHECK(wheel.size() == 2);
+
+    std::vector<u64> late;
+    wheel.advance(wheel.getNow() + 1, [&](u32) { late.push_back(wheel.getNow()); });
+    CHECK(late.size() == 1 && late[0] == wheel.getNow());
+
+    wheel.clear();
+    CHECK(wheel.size() == 0);
+
+    bool firedAfterClear = false;
+    wheel.advance(wheel.getNow() + 200, [&](u32) { firedAfterClear = true; });
+    CHECK(!firedAfterClear);
+
+    return finish();
+}